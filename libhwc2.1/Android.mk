@@ -15,18 +15,33 @@
 LOCAL_SRC_FILES += \
 	../../gs101/libhwc2.1/libdevice/ExynosDeviceModule.cpp \
 	../../gs101/libhwc2.1/libmaindisplay/ExynosPrimaryDisplayModule.cpp \
+	../../zumapro/libhwc2.1/libmaindisplay/DbvTrendPredictor.cpp \
+	../../zumapro/libhwc2.1/libmaindisplay/DisplayColorPreloader.cpp \
+	../../zumapro/libhwc2.1/libmaindisplay/DisplaySettingsStore.cpp \
 	../../zumapro/libhwc2.1/libmaindisplay/ExynosPrimaryDisplayModule.cpp \
+	../../zumapro/libhwc2.1/libmaindisplay/HistogramRoiTracker.cpp \
+	../../zumapro/libhwc2.1/libmaindisplay/HistogramStats.cpp \
+	../../zumapro/libhwc2.1/libmaindisplay/OperationRateController.cpp \
+	../../zumapro/libhwc2.1/libmaindisplay/OperationRatePolicy.cpp \
+	../../zumapro/libhwc2.1/libmaindisplay/OperationRateTelemetry.cpp \
 	../../gs101/libhwc2.1/libresource/ExynosMPPModule.cpp \
 	../../gs201/libhwc2.1/libresource/ExynosMPPModule.cpp \
 	../../zuma/libhwc2.1/libresource/ExynosMPPModule.cpp \
 	../../gs101/libhwc2.1/libresource/ExynosResourceManagerModule.cpp	\
 	../../zuma/libhwc2.1/libresource/ExynosResourceManagerModule.cpp \
+	../../zumapro/libhwc2.1/libresource/ExynosResourceManagerModule.cpp \
+	../../zumapro/libhwc2.1/libresource/TDMAssignmentSolver.cpp \
+	../../zumapro/libhwc2.1/libresource/TDMBudgetLedger.cpp \
+	../../zumapro/libhwc2.1/libresource/TDMResourceModel.cpp \
+	../../zumapro/libhwc2.1/libresource/TDMTrace.cpp \
 	../../gs101/libhwc2.1/libexternaldisplay/ExynosExternalDisplayModule.cpp \
 	../../zuma/libhwc2.1/libexternaldisplay/ExynosExternalDisplayModule.cpp \
 	../../gs101/libhwc2.1/libvirtualdisplay/ExynosVirtualDisplayModule.cpp \
 	../../gs101/libhwc2.1/libdisplayinterface/ExynosDisplayDrmInterfaceModule.cpp \
 	../../gs201/libhwc2.1/libdisplayinterface/ExynosDisplayDrmInterfaceModule.cpp \
 	../../zuma/libhwc2.1/libdisplayinterface/ExynosDisplayDrmInterfaceModule.cpp \
+	../../zumapro/libhwc2.1/libdisplayinterface/ColorBlobCache.cpp \
+	../../zumapro/libhwc2.1/libdisplayinterface/ExynosDisplayDrmInterfaceModule.cpp \
 	../../gs101/libhwc2.1/libcolormanager/ColorManager.cpp \
 	../../zuma/libhwc2.1/libcolormanager/DisplayColorModule.cpp \
 	../../zuma/libhwc2.1/libdevice/ExynosDeviceModule.cpp \
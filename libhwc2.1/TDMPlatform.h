@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _TDM_PLATFORM_ZUMAPRO_H
+#define _TDM_PLATFORM_ZUMAPRO_H
+
+/*
+ * Platform definitions TDMResourceTables.h is keyed on: tdm_attr_t and the format property
+ * bits. Host builds of the TDM model provide their own TDMPlatform.h instead.
+ */
+#include "../../zuma/libhwc2.1/ExynosHWCModule.h"
+#include "ExynosHWCHelper.h"
+
+#endif // _TDM_PLATFORM_ZUMAPRO_H
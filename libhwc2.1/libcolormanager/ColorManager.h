@@ -16,4 +16,49 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include "../../../gs101/libhwc2.1/libcolormanager/ColorManager.h"
+
+namespace zumapro {
+
+/* DPP stages a layer is processed by, one bit per stage */
+enum DppFeature : uint8_t {
+    DPP_FEATURE_EOTF = 1 << 0,
+    DPP_FEATURE_GM = 1 << 1,
+    DPP_FEATURE_DTM = 1 << 2,
+    DPP_FEATURE_OETF = 1 << 3,
+    // not resolved yet, see lookupDppFeatureMasks()
+    DPP_FEATURE_UNKNOWN = 0xff,
+};
+
+template <typename Dpp>
+inline uint8_t getDppFeatureMask(const Dpp& dpp) {
+    return (dpp.EotfLut().enable ? DPP_FEATURE_EOTF : 0) | (dpp.Gm().enable ? DPP_FEATURE_GM : 0) |
+            (dpp.Dtm().enable ? DPP_FEATURE_DTM : 0) |
+            (dpp.OetfLut().enable ? DPP_FEATURE_OETF : 0);
+}
+
+/*
+ * DPP features of the client target and the layers of a frame in one contiguous array, the
+ * client target at index 0 and layers[i] at index i + 1. Entries that are not
+ * DPP_FEATURE_UNKNOWN are kept, so a caller can fill in what it already knows. This is only
+ * a helper around ColorManager::getDppForLayer(), every unknown entry is one more lookup.
+ */
+template <typename Layers>
+inline void lookupDppFeatureMasks(ColorManager& colorManager, ExynosMPPSource* clientTarget,
+                                  const Layers& layers, std::vector<uint8_t>* masks) {
+    masks->resize(layers.size() + 1, DPP_FEATURE_UNKNOWN);
+    uint8_t* mask = masks->data();
+    if (mask[0] == DPP_FEATURE_UNKNOWN) {
+        mask[0] = getDppFeatureMask(colorManager.getDppForLayer(clientTarget));
+    }
+    for (size_t i = 0; i < layers.size(); i++) {
+        if (mask[i + 1] != DPP_FEATURE_UNKNOWN) continue;
+        mask[i + 1] = getDppFeatureMask(colorManager.getDppForLayer(layers[i]));
+    }
+}
+
+} // namespace zumapro
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ColorBlobCache.h"
+
+#include <algorithm>
+
+using namespace zumapro;
+
+uint64_t ColorBlobCache::getHash(const void* data, size_t size) {
+    // FNV-1a, a LUT of a few KB per stage
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    return hash;
+}
+
+void ColorBlobCache::bindPlane(uint32_t planeId, const void* source) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto [it, added] = mPlaneSources.try_emplace(planeId, source);
+    if (!added && it->second == source) return;
+    it->second = source;
+    for (uint32_t stage = 0; stage < STAGE_CNT; stage++) {
+        mEntries.erase(getKey(planeId, static_cast<Stage>(stage)));
+    }
+}
+
+bool ColorBlobCache::update(uint32_t planeId, Stage stage, const void* data, size_t size) {
+    const Entry entry = {getHash(data, size), size};
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto [it, added] = mEntries.try_emplace(getKey(planeId, stage), entry);
+    if (!added && it->second.hash == entry.hash && it->second.size == entry.size) {
+        mStats.skippedBytes += size;
+        return false;
+    }
+    it->second = entry;
+    mStats.writtenBytes += size;
+    mFrameWrittenBytes += size;
+    return true;
+}
+
+void ColorBlobCache::forget(uint32_t planeId, Stage stage) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.erase(getKey(planeId, stage));
+}
+
+void ColorBlobCache::invalidate() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.clear();
+    mPlaneSources.clear();
+}
+
+void ColorBlobCache::beginFrame() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFrameWrittenBytes = 0;
+}
+
+void ColorBlobCache::endFrame() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.frameCnt++;
+    mStats.lastFrameWrittenBytes = mFrameWrittenBytes;
+    mStats.maxFrameWrittenBytes = std::max(mStats.maxFrameWrittenBytes, mFrameWrittenBytes);
+}
+
+ColorBlobCache::Stats_t ColorBlobCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _COLOR_BLOB_CACHE_ZUMAPRO_H
+#define _COLOR_BLOB_CACHE_ZUMAPRO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace zumapro {
+
+/*
+ * Content hashes of the DPP color stages last programmed on each plane. The color library
+ * marks a stage dirty whenever it recomputes it, also if the LUT or matrix came out the
+ * same, and every dirty stage costs a new blob. A stage whose payload matches the blob the
+ * plane already has can keep it instead. The payloads are only known for the layer last
+ * bound to the plane. The commit path calls bindPlane(), update() and the frame hooks,
+ * getStats() can be called from any thread.
+ */
+class ColorBlobCache {
+public:
+    enum Stage : uint32_t {
+        EOTF = 0,
+        GM,
+        DTM,
+        OETF,
+        STAGE_CNT,
+    };
+
+    struct Stats_t {
+        uint64_t frameCnt;
+        // payload bytes of the blobs created and of the ones left out, since boot
+        uint64_t writtenBytes;
+        uint64_t skippedBytes;
+        uint64_t lastFrameWrittenBytes;
+        uint64_t maxFrameWrittenBytes;
+    };
+
+    // forget the stages of the plane if it now shows another layer
+    void bindPlane(uint32_t planeId, const void* source);
+    /*
+     * return true if the payload differs from the one last programmed on the stage of the
+     * plane, which is then expected to be programmed
+     */
+    bool update(uint32_t planeId, Stage stage, const void* data, size_t size);
+    // the stage is disabled or programmed with a payload the cache did not see
+    void forget(uint32_t planeId, Stage stage);
+    // the planes lost their blobs, e.g. when the display is turned off
+    void invalidate();
+    void beginFrame();
+    void endFrame();
+    Stats_t getStats() const;
+
+    static uint64_t getHash(const void* data, size_t size);
+
+private:
+    struct Entry {
+        uint64_t hash;
+        size_t size;
+    };
+    static uint64_t getKey(uint32_t planeId, Stage stage) {
+        return static_cast<uint64_t>(planeId) * STAGE_CNT + stage;
+    }
+
+    mutable std::mutex mMutex;
+    std::unordered_map<uint64_t, Entry> mEntries;
+    std::unordered_map<uint32_t, const void*> mPlaneSources;
+    uint64_t mFrameWrittenBytes = 0;
+    Stats_t mStats = {};
+};
+
+} // namespace zumapro
+
+#endif // _COLOR_BLOB_CACHE_ZUMAPRO_H
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ExynosDisplayDrmInterfaceModule.h"
+
+#include <cinttypes>
+#include <type_traits>
+
+#include "ColorManager.h"
+#include "ExynosPrimaryDisplayModule.h"
+
+using namespace zumapro;
+
+int32_t ExynosPrimaryDisplayDrmInterfaceModule::setPowerMode(int32_t mode) {
+    if (mode == HWC_POWER_MODE_OFF) mColorBlobCache.invalidate();
+    return zuma::ExynosPrimaryDisplayDrmInterfaceModule::setPowerMode(mode);
+}
+
+int32_t ExynosPrimaryDisplayDrmInterfaceModule::deliverWinConfigData() {
+    mColorBlobCache.beginFrame();
+    int32_t ret = zuma::ExynosPrimaryDisplayDrmInterfaceModule::deliverWinConfigData();
+    // a failed commit may have left the planes with other blobs than the ones recorded
+    if (ret != NO_ERROR) mColorBlobCache.invalidate();
+    mColorBlobCache.endFrame();
+    return ret;
+}
+
+template <typename T>
+void ExynosPrimaryDisplayDrmInterfaceModule::checkColorStage(uint32_t planeId,
+                                                             ColorBlobCache::Stage type,
+                                                             const T& stage) {
+    if (!stage.enable) {
+        mColorBlobCache.forget(planeId, type);
+        return;
+    }
+    // a clean stage reuses the blob the cache recorded for the layer on this plane
+    if (!stage.dirty) return;
+
+    using Config = std::remove_cv_t<std::remove_pointer_t<decltype(stage.config)>>;
+    if constexpr (std::is_trivially_copyable_v<Config>) {
+        if (stage.config &&
+            !mColorBlobCache.update(planeId, type, stage.config, sizeof(Config))) {
+            // the base module keeps the old blob of a clean stage
+            stage.NotifyDataApplied();
+        }
+    } else {
+        mColorBlobCache.forget(planeId, type);
+    }
+}
+
+int32_t ExynosPrimaryDisplayDrmInterfaceModule::setPlaneColorSetting(
+        ExynosDisplayDrmInterface::DrmModeAtomicReq& drmReq,
+        const std::unique_ptr<DrmPlane>& plane, const exynos_win_config_data& config,
+        uint32_t& solidColor) {
+    const ExynosMPP* mpp = config.assignedMPP;
+    auto* display = static_cast<ExynosPrimaryDisplayModule*>(mExynosDisplay);
+    ColorManager* colorManager = display->getColorManager();
+    const uint32_t planeId = plane->id();
+    if (mpp && colorManager && mpp->mAssignedSources.size() == 1) {
+        ExynosMPPSource* source = mpp->mAssignedSources[0];
+        mColorBlobCache.bindPlane(planeId, source);
+
+        auto& dpp = colorManager->getDppForLayer(source);
+        checkColorStage(planeId, ColorBlobCache::EOTF, dpp.EotfLut());
+        checkColorStage(planeId, ColorBlobCache::GM, dpp.Gm());
+        checkColorStage(planeId, ColorBlobCache::DTM, dpp.Dtm());
+        checkColorStage(planeId, ColorBlobCache::OETF, dpp.OetfLut());
+    } else {
+        mColorBlobCache.bindPlane(planeId, nullptr);
+    }
+    return zuma::ExynosPrimaryDisplayDrmInterfaceModule::setPlaneColorSetting(drmReq, plane,
+                                                                              config,
+                                                                              solidColor);
+}
+
+void ExynosPrimaryDisplayDrmInterfaceModule::dumpColorBlobs(String8& result) const {
+    const ColorBlobCache::Stats_t stats = mColorBlobCache.getStats();
+    result.appendFormat("DPP color blobs: frames %" PRIu64 ", written %" PRIu64
+                        " bytes, skipped %" PRIu64 " bytes, last frame %" PRIu64
+                        " bytes, max frame %" PRIu64 " bytes\n",
+                        stats.frameCnt, stats.writtenBytes, stats.skippedBytes,
+                        stats.lastFrameWrittenBytes, stats.maxFrameWrittenBytes);
+}
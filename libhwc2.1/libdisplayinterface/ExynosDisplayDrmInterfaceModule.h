@@ -14,15 +14,37 @@
  * limitations under the License.
  */
 
+
 #ifndef EXYNOS_DISPLAY_DRM_INTERFACE_MODULE_ZUMAPRO_H
 #define EXYNOS_DISPLAY_DRM_INTERFACE_MODULE_ZUMAPRO_H
 
 #include "../../zuma/libhwc2.1/libdisplayinterface/ExynosDisplayDrmInterfaceModule.h"
+#include "ColorBlobCache.h"
 
 namespace zumapro {
 
-using ExynosPrimaryDisplayDrmInterfaceModule =
-    zuma::ExynosPrimaryDisplayDrmInterfaceModule;
+/*
+ * Keeps the color blobs of a plane when the color library recomputed a DPP stage to the
+ * payload the plane already has, see ColorBlobCache.
+ */
+class ExynosPrimaryDisplayDrmInterfaceModule : public zuma::ExynosPrimaryDisplayDrmInterfaceModule {
+public:
+    using zuma::ExynosPrimaryDisplayDrmInterfaceModule::ExynosPrimaryDisplayDrmInterfaceModule;
+
+    int32_t setPowerMode(int32_t mode) override;
+    int32_t deliverWinConfigData() override;
+    int32_t setPlaneColorSetting(ExynosDisplayDrmInterface::DrmModeAtomicReq& drmReq,
+                                 const std::unique_ptr<DrmPlane>& plane,
+                                 const exynos_win_config_data& config,
+                                 uint32_t& solidColor) override;
+    void dumpColorBlobs(String8& result) const;
+
+private:
+    template <typename T>
+    void checkColorStage(uint32_t planeId, ColorBlobCache::Stage type, const T& stage);
+
+    ColorBlobCache mColorBlobCache;
+};
 
 using ExynosExternalDisplayDrmInterfaceModule =
     zuma::ExynosExternalDisplayDrmInterfaceModule;
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <array>
+
+#include "ColorBlobCache.h"
+
+using namespace zumapro;
+
+namespace {
+
+constexpr uint32_t kPlane0 = 31;
+constexpr uint32_t kPlane1 = 32;
+
+using Lut_t = std::array<uint16_t, 1024>;
+constexpr uint64_t kLutSize = sizeof(Lut_t);
+
+Lut_t getLut(uint16_t gain) {
+    Lut_t lut;
+    for (size_t i = 0; i < lut.size(); i++) lut[i] = static_cast<uint16_t>(i * gain);
+    return lut;
+}
+
+/* the stages of an HDR layer the color library marks dirty on each frame */
+void programHdrLayer(ColorBlobCache& cache, uint32_t planeId, const void* layer,
+                     const Lut_t& eotf, const Lut_t& oetf, std::array<bool, 2>* updated) {
+    cache.beginFrame();
+    cache.bindPlane(planeId, layer);
+    (*updated)[0] = cache.update(planeId, ColorBlobCache::EOTF, eotf.data(), kLutSize);
+    (*updated)[1] = cache.update(planeId, ColorBlobCache::OETF, oetf.data(), kLutSize);
+    cache.endFrame();
+}
+
+} // namespace
+
+TEST(ColorBlobCacheTest, SteadyHdrLayerWritesNothing) {
+    ColorBlobCache cache;
+    const int layer = 0;
+    const Lut_t eotf = getLut(3);
+    const Lut_t oetf = getLut(5);
+    std::array<bool, 2> updated;
+
+    programHdrLayer(cache, kPlane0, &layer, eotf, oetf, &updated);
+    EXPECT_EQ(updated, (std::array<bool, 2>{true, true}));
+    for (int i = 0; i < 10; i++) {
+        // recomputed into new storage with the same content
+        const Lut_t eotfCopy = eotf;
+        const Lut_t oetfCopy = oetf;
+        programHdrLayer(cache, kPlane0, &layer, eotfCopy, oetfCopy, &updated);
+        EXPECT_EQ(updated, (std::array<bool, 2>{false, false}));
+    }
+
+    const ColorBlobCache::Stats_t stats = cache.getStats();
+    EXPECT_EQ(stats.frameCnt, 11);
+    EXPECT_EQ(stats.writtenBytes, 2 * kLutSize);
+    EXPECT_EQ(stats.skippedBytes, 20 * kLutSize);
+    EXPECT_EQ(stats.lastFrameWrittenBytes, 0);
+    EXPECT_EQ(stats.maxFrameWrittenBytes, 2 * kLutSize);
+}
+
+TEST(ColorBlobCacheTest, ChangedLutIsWritten) {
+    ColorBlobCache cache;
+    const int layer = 0;
+    std::array<bool, 2> updated;
+
+    programHdrLayer(cache, kPlane0, &layer, getLut(3), getLut(5), &updated);
+    programHdrLayer(cache, kPlane0, &layer, getLut(3), getLut(6), &updated);
+    EXPECT_EQ(updated, (std::array<bool, 2>{false, true}));
+    EXPECT_EQ(cache.getStats().lastFrameWrittenBytes, kLutSize);
+
+    // back to the first payload, the plane has the blob of the second one
+    programHdrLayer(cache, kPlane0, &layer, getLut(3), getLut(5), &updated);
+    EXPECT_EQ(updated, (std::array<bool, 2>{false, true}));
+
+    // same bytes, different length
+    cache.beginFrame();
+    const Lut_t eotf = getLut(3);
+    EXPECT_TRUE(cache.update(kPlane0, ColorBlobCache::EOTF, eotf.data(), kLutSize / 2));
+    cache.endFrame();
+}
+
+TEST(ColorBlobCacheTest, PlanesAndStagesAreSeparate) {
+    ColorBlobCache cache;
+    const Lut_t lut = getLut(3);
+
+    EXPECT_TRUE(cache.update(kPlane0, ColorBlobCache::EOTF, lut.data(), kLutSize));
+    EXPECT_TRUE(cache.update(kPlane0, ColorBlobCache::OETF, lut.data(), kLutSize));
+    EXPECT_TRUE(cache.update(kPlane1, ColorBlobCache::EOTF, lut.data(), kLutSize));
+    EXPECT_FALSE(cache.update(kPlane1, ColorBlobCache::EOTF, lut.data(), kLutSize));
+}
+
+TEST(ColorBlobCacheTest, Invalidation) {
+    ColorBlobCache cache;
+    const int layer0 = 0;
+    const int layer1 = 0;
+    const Lut_t lut = getLut(3);
+    std::array<bool, 2> updated;
+
+    programHdrLayer(cache, kPlane0, &layer0, lut, lut, &updated);
+    programHdrLayer(cache, kPlane1, &layer1, lut, lut, &updated);
+
+    // the stage was disabled, the plane dropped its blob
+    cache.forget(kPlane0, ColorBlobCache::EOTF);
+    programHdrLayer(cache, kPlane0, &layer0, lut, lut, &updated);
+    EXPECT_EQ(updated, (std::array<bool, 2>{true, false}));
+
+    // another layer moved to the plane, its stages were not seen on it
+    programHdrLayer(cache, kPlane0, &layer1, lut, lut, &updated);
+    EXPECT_EQ(updated, (std::array<bool, 2>{true, true}));
+    programHdrLayer(cache, kPlane1, &layer1, lut, lut, &updated);
+    EXPECT_EQ(updated, (std::array<bool, 2>{false, false}));
+
+    // display turned off
+    cache.invalidate();
+    programHdrLayer(cache, kPlane0, &layer1, lut, lut, &updated);
+    EXPECT_EQ(updated, (std::array<bool, 2>{true, true}));
+    programHdrLayer(cache, kPlane1, &layer1, lut, lut, &updated);
+    EXPECT_EQ(updated, (std::array<bool, 2>{true, true}));
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DbvTrendPredictor.h"
+
+#include <cmath>
+
+using namespace zumapro;
+
+// weight of the newest step in the slope average
+static constexpr double kSlopeWeight = 0.5;
+
+DbvTrendPredictor::DbvTrendPredictor(Config_t config)
+      : mConfig(config),
+        mDbv(0),
+        mTimeNs(0),
+        mSlopePerNs(0),
+        mPredicted(false),
+        mPredictedNs(0),
+        mStats{} {}
+
+void DbvTrendPredictor::onDbv(int32_t dbv, int32_t threshold, int64_t nowNs) {
+    if (!isEnabled()) return;
+
+    int64_t stepNs = nowNs - mTimeNs;
+    if (!mTimeNs || stepNs <= 0 || stepNs > mConfig.maxStepNs) {
+        mSlopePerNs = 0;
+    } else {
+        double slope = static_cast<double>(dbv - mDbv) / stepNs;
+        mSlopePerNs = mSlopePerNs ? mSlopePerNs * (1 - kSlopeWeight) + slope * kSlopeWeight
+                                  : slope;
+    }
+    bool crossed = mDbv >= threshold && dbv < threshold;
+    mDbv = dbv;
+    mTimeNs = nowNs;
+
+    // a prediction is judged within two horizons
+    if (mPredicted && nowNs - mPredictedNs > 2 * mConfig.horizonNs) {
+        mPredicted = false;
+        mStats.falseAlarmCnt++;
+    }
+    if (crossed) {
+        if (mPredicted) {
+            mStats.hitCnt++;
+            mStats.totalLeadNs += nowNs - mPredictedNs;
+            mPredicted = false;
+        } else {
+            mStats.missedCnt++;
+        }
+    } else if (!mPredicted && dbv >= threshold && predict() < threshold) {
+        mPredicted = true;
+        mPredictedNs = nowNs;
+        mStats.predictedCnt++;
+    }
+}
+
+int32_t DbvTrendPredictor::predict() const {
+    return mDbv + static_cast<int32_t>(std::lround(mSlopePerNs * mConfig.horizonNs));
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _DBV_TREND_PREDICTOR_ZUMAPRO_H
+#define _DBV_TREND_PREDICTOR_ZUMAPRO_H
+
+#include <cstdint>
+
+namespace zumapro {
+
+/*
+ * Slope of a brightness ramp, so the operation rate can switch before the ramp crosses into
+ * the blocking zone instead of after it. The slope is a moving average of the dbv change
+ * per time, reset when updates stop for longer than a ramp step. Only ramps going down are
+ * tracked for accuracy, since those are the ones entering the blocking zone.
+ */
+class DbvTrendPredictor {
+public:
+    struct Config_t {
+        int64_t horizonNs; // how far ahead to predict, 0 disables the predictor
+        int64_t maxStepNs; // longer gaps between updates end the ramp
+    };
+
+    struct Stats_t {
+        uint64_t predictedCnt;  // crossings predicted ahead of time
+        uint64_t hitCnt;        // predicted crossings that happened
+        uint64_t falseAlarmCnt; // predicted crossings that did not happen in time
+        uint64_t missedCnt;     // crossings that were not predicted
+        int64_t totalLeadNs;    // sum of prediction lead times of the hits
+    };
+
+    explicit DbvTrendPredictor(Config_t config);
+
+    bool isEnabled() const { return mConfig.horizonNs > 0; }
+    // `threshold` is the dbv below which the panel is in the blocking zone
+    void onDbv(int32_t dbv, int32_t threshold, int64_t nowNs);
+    // dbv expected at the end of the horizon, the last dbv without a ramp
+    int32_t predict() const;
+    const Stats_t& getStats() const { return mStats; }
+
+private:
+    const Config_t mConfig;
+    int32_t mDbv;
+    int64_t mTimeNs;
+    double mSlopePerNs;
+
+    bool mPredicted;
+    int64_t mPredictedNs;
+    Stats_t mStats;
+};
+
+} // namespace zumapro
+
+#endif // _DBV_TREND_PREDICTOR_ZUMAPRO_H
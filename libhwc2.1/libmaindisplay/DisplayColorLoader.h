@@ -21,6 +21,12 @@
 
 namespace zumapro {
 
+/*
+ * The per-mode gamma, gamut and DTM tables are not cached across boots. libdisplaycolor
+ * reads the panel calibration and computes the tables itself when the interface object is
+ * created, and has no entry point to import precomputed ones, so a cache kept here could
+ * never replace the recomputation.
+ */
 using DisplayColorLoader = zuma::DisplayColorLoader;
 
 } // namespace zumapro
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "DisplayColorPreloader.h"
+
+#include <dlfcn.h>
+
+#include <chrono>
+
+using namespace zumapro;
+
+DisplayColorPreloader::DisplayColorPreloader(const char* libName)
+      : mThread(&DisplayColorPreloader::load, this, libName) {}
+
+DisplayColorPreloader::~DisplayColorPreloader() {
+    wait();
+    if (void* handle = mHandle.exchange(nullptr)) dlclose(handle);
+}
+
+void DisplayColorPreloader::wait() {
+    if (mThread.joinable()) mThread.join();
+}
+
+void DisplayColorPreloader::load(const char* libName) {
+    auto start = std::chrono::steady_clock::now();
+    void* handle = dlopen(libName, RTLD_NOW);
+    mLoadNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+    if (!handle) {
+        const char* error = dlerror();
+        mError = error ? error : "unknown error";
+        mState.store(State::FAILED, std::memory_order_release);
+        return;
+    }
+    mHandle.store(handle, std::memory_order_release);
+    mState.store(State::READY, std::memory_order_release);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _DISPLAY_COLOR_PRELOADER_ZUMAPRO_H
+#define _DISPLAY_COLOR_PRELOADER_ZUMAPRO_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace zumapro {
+
+/*
+ * Maps the display color library on a background thread while the displays are created. The
+ * device module still loads it synchronously, but then only takes another reference on the
+ * resident library instead of mapping and relocating it on the init path. The handle is
+ * published once the library is mapped.
+ * getState() and getHandle() may be called from any thread, the rest from the owner.
+ */
+class DisplayColorPreloader {
+public:
+    enum class State : uint8_t {
+        LOADING,
+        READY,
+        FAILED,
+    };
+
+    // `libName` must outlive the preloader
+    explicit DisplayColorPreloader(const char* libName);
+    // waits for the background thread and drops the reference of the preload
+    ~DisplayColorPreloader();
+
+    State getState() const { return mState.load(std::memory_order_acquire); }
+    // the library handle once READY, nullptr before and on failure
+    void* getHandle() const { return mHandle.load(std::memory_order_acquire); }
+    // waits until the state is READY or FAILED
+    void wait();
+    // time the background thread took to map the library, once READY or FAILED
+    int64_t getLoadNs() const { return mLoadNs; }
+    // dlerror() of the failed load, once FAILED
+    const std::string& getError() const { return mError; }
+
+private:
+    void load(const char* libName);
+
+    std::atomic<State> mState = State::LOADING;
+    std::atomic<void*> mHandle = nullptr;
+    // written by the background thread before the state leaves LOADING
+    int64_t mLoadNs = 0;
+    std::string mError;
+    std::thread mThread;
+};
+
+} // namespace zumapro
+
+#endif // _DISPLAY_COLOR_PRELOADER_ZUMAPRO_H
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DisplaySettingsStore.h"
+
+#include <cutils/properties.h>
+#include <log/log.h>
+#include <utils/ThreadDefs.h>
+
+#include <chrono>
+#include <cinttypes>
+
+using namespace zumapro;
+using namespace std::chrono_literals;
+
+// set by init after it loads the persistent properties
+static constexpr const char* kPersistReadyProp = "ro.persistent_properties.ready";
+static constexpr int64_t kLoadRetryNanosecs = std::chrono::nanoseconds(100ms).count();
+
+DisplaySettingsStore::DisplaySettingsStore(std::vector<std::string> keys)
+      : Worker("DisplaySettingsStore", ANDROID_PRIORITY_BACKGROUND),
+        mKeys(std::move(keys)),
+        mLoaded(false),
+        mWriteCnt(0),
+        mCoalescedCnt(0),
+        mFailedCnt(0) {
+    InitWorker();
+}
+
+DisplaySettingsStore::~DisplaySettingsStore() {
+    Exit();
+    // the thread is gone, write what is left
+    flush();
+}
+
+bool DisplaySettingsStore::isLoaded() {
+    Lock();
+    bool loaded = mLoaded;
+    Unlock();
+    return loaded;
+}
+
+int32_t DisplaySettingsStore::getInt32(const std::string& key, int32_t defaultValue) {
+    int32_t value = defaultValue;
+    Lock();
+    auto it = mValues.find(key);
+    if (it != mValues.end() && !it->second.empty()) {
+        value = atoi(it->second.c_str());
+    }
+    Unlock();
+    return value;
+}
+
+void DisplaySettingsStore::setInt32(const std::string& key, int32_t value) {
+    std::string valueStr = std::to_string(value);
+    Lock();
+    mValues[key] = valueStr;
+    if (!mPending.insert_or_assign(key, std::move(valueStr)).second) mCoalescedCnt++;
+    Unlock();
+    Signal();
+}
+
+void DisplaySettingsStore::load() {
+    // no lock held for the reads, written values win over the loaded ones
+    std::map<std::string, std::string> values;
+    char value[PROPERTY_VALUE_MAX];
+    for (const std::string& key : mKeys) {
+        if (property_get(key.c_str(), value, "") > 0) values[key] = value;
+    }
+
+    Lock();
+    mValues.merge(values);
+    mLoaded = true;
+    Unlock();
+}
+
+void DisplaySettingsStore::flush() {
+    Lock();
+    std::map<std::string, std::string> pending = std::move(mPending);
+    mPending.clear();
+    Unlock();
+
+    for (const auto& [key, value] : pending) {
+        if (property_set(key.c_str(), value.c_str()) < 0) {
+            ALOGE("DisplaySettingsStore: failed to set property %s", key.c_str());
+            Lock();
+            mFailedCnt++;
+            Unlock();
+            continue;
+        }
+        Lock();
+        mWriteCnt++;
+        Unlock();
+    }
+}
+
+void DisplaySettingsStore::Routine() {
+    bool loaded = isLoaded();
+    if (!loaded && property_get_bool(kPersistReadyProp, false)) {
+        load();
+        loaded = true;
+    }
+
+    Lock();
+    int ret = 0;
+    // writes before the load wait for it, init would replace them with the stored values
+    if (!loaded) {
+        ret = WaitForSignalOrExitLocked(kLoadRetryNanosecs);
+    } else if (mPending.empty()) {
+        ret = WaitForSignalOrExitLocked();
+    }
+    Unlock();
+    if (ret == -EINTR || !loaded) return;
+
+    flush();
+}
+
+void DisplaySettingsStore::dump(String8& result) {
+    Lock();
+    result.appendFormat("Display settings: loaded %d, pending %zu, writes %" PRIu64
+                        " (coalesced %" PRIu64 ", failed %" PRIu64 ")\n",
+                        mLoaded, mPending.size(), mWriteCnt, mCoalescedCnt, mFailedCnt);
+    Unlock();
+}
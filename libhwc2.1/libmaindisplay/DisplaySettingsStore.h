@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _DISPLAY_SETTINGS_STORE_ZUMAPRO_H
+#define _DISPLAY_SETTINGS_STORE_ZUMAPRO_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ExynosHWCHelper.h"
+#include "worker.h"
+
+namespace zumapro {
+
+/*
+ * Property cache for the display hooks. Persistent property writes go through init and can
+ * take milliseconds, so writes are queued and flushed on a background thread, and a later
+ * write of the same key replaces a queued one. Reads are served from the cache, which the
+ * thread fills once init has loaded the persistent properties.
+ */
+class DisplaySettingsStore : public Worker {
+public:
+    // `keys` are read into the cache at load, other keys are cached once written
+    explicit DisplaySettingsStore(std::vector<std::string> keys);
+    ~DisplaySettingsStore();
+
+    // false until the persistent properties are available
+    bool isLoaded();
+    // cached value, `defaultValue` if unset or not loaded yet
+    int32_t getInt32(const std::string& key, int32_t defaultValue);
+    void setInt32(const std::string& key, int32_t value);
+    void dump(String8& result);
+
+protected:
+    void Routine() override;
+
+private:
+    void load();
+    void flush();
+
+    const std::vector<std::string> mKeys;
+    // all below are guarded by the worker lock
+    bool mLoaded;
+    std::map<std::string, std::string> mValues;
+    std::map<std::string, std::string> mPending;
+
+    uint64_t mWriteCnt;
+    uint64_t mCoalescedCnt;
+    uint64_t mFailedCnt;
+};
+
+} // namespace zumapro
+
+#endif // _DISPLAY_SETTINGS_STORE_ZUMAPRO_H
@@ -20,6 +20,13 @@
 #include <android/binder_status.h>
 #include <cutils/properties.h>
 
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+
+#include "ColorManager.h"
+#include "ExynosDisplayDrmInterfaceModule.h"
 #include "ExynosHWCHelper.h"
 #include "ExynosPrimaryDisplayModule.h"
 
@@ -33,78 +40,503 @@
     ALOGE("[%s] OperationRateManager::%s:" msg, DISP_STR(disp), __func__, ##__VA_ARGS__)
 
 static constexpr int64_t kQueryPeriodNanosecs = std::chrono::nanoseconds(100ms).count();
+static constexpr const char* kPersistPeakRefreshRateProp =
+        "persist.vendor.primarydisplay.op.peak_refresh_rate";
+static constexpr const char* kVendorPeakRefreshRateProp =
+        "vendor.primarydisplay.op.peak_refresh_rate";
 
 using namespace zumapro;
 
+// indexed by OperationRatePolicy::Condition
+static constexpr const char* kConditionNames[] = {"power", "config", "dbv", "histogram",
+                                                  "dwell"};
+static_assert(std::size(kConditionNames) == OperationRateStats_t::kConditionCnt);
+
+static uint64_t getColorTransformHash(const ExynosLayer* layer) {
+    const auto& transform = layer->mLayerColorTransform;
+    if (!transform.enable) return 0;
+    return LayerStackFingerprint::hashBytes(transform.mat.data(),
+                                            sizeof(float) * transform.mat.size());
+}
+
+static uint64_t getHdrMetadataHash(const ExynosLayer* layer) {
+    const ExynosVideoMeta* meta = layer->mMetaParcel;
+    if (!meta) return 0;
+    uint64_t hash = 0;
+    if (meta->eType & VIDEO_INFO_TYPE_HDR_STATIC) {
+        hash = LayerStackFingerprint::hashBytes(&meta->sHdrStaticInfo,
+                                                sizeof(meta->sHdrStaticInfo));
+    }
+    if (meta->eType & VIDEO_INFO_TYPE_HDR_DYNAMIC) {
+        hash = LayerStackFingerprint::hashBytes(&meta->sHdrDynamicInfo,
+                                                sizeof(meta->sHdrDynamicInfo), hash);
+    }
+    return hash;
+}
+
 ExynosPrimaryDisplayModule::ExynosPrimaryDisplayModule(uint32_t index, ExynosDevice* device,
                                                        const std::string& displayName)
       : gs201::ExynosPrimaryDisplayModule(index, device, displayName) {
+    // the device module loads the library after all displays are created
+    if (property_get_bool("vendor.primarydisplay.displaycolor_preload", false)) {
+        mDisplayColorPreloader = std::make_unique<DisplayColorPreloader>(DISPLAY_COLOR_LIB);
+    }
+
     int32_t hs_hz = property_get_int32("vendor.primarydisplay.op.hs_hz", 0);
     int32_t ns_hz = property_get_int32("vendor.primarydisplay.op.ns_hz", 0);
+    // all supported operation rates, the lowest and the highest replace ns_hz and hs_hz
+    std::vector<int32_t> rates = parseOperationRates("vendor.primarydisplay.op.rates");
+    if (rates.size() >= 2) {
+        ns_hz = rates.front();
+        hs_hz = rates.back();
+    } else {
+        rates = {ns_hz, hs_hz};
+    }
 
     if (hs_hz && ns_hz) {
-        mOperationRateManager = std::make_unique<OperationRateManager>(this, hs_hz, ns_hz);
+        mOperationRateManager =
+                std::make_unique<OperationRateManager>(this, hs_hz, ns_hz, std::move(rates));
     }
 }
 
 ExynosPrimaryDisplayModule::~ExynosPrimaryDisplayModule() {}
 
+std::vector<int32_t> ExynosPrimaryDisplayModule::parseOperationRates(const char* prop) {
+    char value[PROP_VALUE_MAX];
+    std::vector<int32_t> rates;
+    if (property_get(prop, value, "") <= 0) return rates;
+
+    for (char* token = strtok(value, ", "); token; token = strtok(nullptr, ", ")) {
+        int32_t rate = atoi(token);
+        if (rate <= 0) {
+            ALOGE("%s: invalid operation rate '%s' in %s", __func__, token, prop);
+            return {};
+        }
+        rates.push_back(rate);
+    }
+    std::sort(rates.begin(), rates.end());
+    rates.erase(std::unique(rates.begin(), rates.end()), rates.end());
+    return rates;
+}
+
 int32_t ExynosPrimaryDisplayModule::validateWinConfigData() {
+    if (mOperationRateManager) {
+        auto* opRateManager = static_cast<OperationRateManager*>(mOperationRateManager.get());
+        opRateManager->onFrameUpdate(opRateManager->needsFrameDamage()
+                                             ? computeFrameDamage()
+                                             : HistogramRoiTracker::Rect_t{});
+    }
     return ExynosDisplay::validateWinConfigData();
 }
 
+int32_t ExynosPrimaryDisplayModule::presentDisplay(int32_t* outRetireFence) {
+    int32_t ret = gs201::ExynosPrimaryDisplayModule::presentDisplay(outRetireFence);
+    if (mOperationRateManager && ret == HWC2_ERROR_NONE) {
+        static_cast<OperationRateManager*>(mOperationRateManager.get())->onFramePresented();
+    }
+    return ret;
+}
+
+void ExynosPrimaryDisplayModule::dump(String8& result) {
+    gs201::ExynosPrimaryDisplayModule::dump(result);
+
+    if (mOperationRateManager) {
+        static_cast<OperationRateManager*>(mOperationRateManager.get())->dump(result);
+    }
+    auto* resourceManager = static_cast<ExynosResourceManagerModule*>(mDevice->mResourceManager);
+    resourceManager->dumpAxiLoad(this, result);
+    dumpLayerStackCache(result);
+    if (mDisplayInterface && mDisplayInterface->mType == INTERFACE_TYPE_DRM) {
+        static_cast<ExynosPrimaryDisplayDrmInterfaceModule*>(mDisplayInterface.get())
+                ->dumpColorBlobs(result);
+    }
+    result.appendFormat("\n");
+}
+
+int32_t ExynosPrimaryDisplayModule::setPowerMode(int32_t mode) {
+    invalidateLayerStackCache();
+    return gs201::ExynosPrimaryDisplayModule::setPowerMode(mode);
+}
+
+int32_t ExynosPrimaryDisplayModule::setColorModeWithRenderIntent(int32_t mode, int32_t intent) {
+    invalidateLayerStackCache();
+    return gs201::ExynosPrimaryDisplayModule::setColorModeWithRenderIntent(mode, intent);
+}
+
+int32_t ExynosPrimaryDisplayModule::setColorTransform(const float* matrix, int32_t hint) {
+    invalidateLayerStackCache();
+    return gs201::ExynosPrimaryDisplayModule::setColorTransform(matrix, hint);
+}
+
+int32_t ExynosPrimaryDisplayModule::setDisplayBrightness(float brightness, bool waitPresent) {
+    // the DPP tone mapping of HDR layers follows the display brightness
+    invalidateLayerStackCache();
+    return gs201::ExynosPrimaryDisplayModule::setDisplayBrightness(brightness, waitPresent);
+}
+
+int32_t ExynosPrimaryDisplayModule::destroyLayer(hwc2_layer_t outLayer) {
+    // the next layer created at this address must not find the cached decision
+    auto& layerCache = mPreblendingCache;
+    auto* source = static_cast<const ExynosMPPSource*>(reinterpret_cast<ExynosLayer*>(outLayer));
+    if (auto id = layerCache.layerIds.find(source); id != layerCache.layerIds.end()) {
+        for (auto it = layerCache.entries.begin(); it != layerCache.entries.end();) {
+            it = it->first.layerId == id->second ? layerCache.entries.erase(it) : std::next(it);
+        }
+        layerCache.layerIds.erase(id);
+    }
+    return gs201::ExynosPrimaryDisplayModule::destroyLayer(outLayer);
+}
+
+uint64_t ExynosPrimaryDisplayModule::computeLayerStackFingerprint() {
+    LayerStackFingerprint fingerprint(mLayers.size(), mActiveConfig, mXres, mYres,
+                                      mPreblendingCache.generation);
+    for (size_t i = 0; i < mLayers.size(); i++) {
+        const ExynosLayer* layer = mLayers[i];
+        const hwc_frect_t& crop = layer->mSourceCrop;
+        const hwc_rect_t& frame = layer->mDisplayFrame;
+        LayerStackKey_t key = {
+                {crop.left, crop.top, crop.right, crop.bottom},
+                {frame.left, frame.top, frame.right, frame.bottom},
+                layer->mTransform,
+                layer->mDataSpace,
+                layer->mLayerBuffer ? VendorGraphicBufferMeta::get_format(layer->mLayerBuffer)
+                                    : 0,
+                layer->mCompressionInfo.type,
+                layer->mIsHdrLayer,
+                layer->mBrightness,
+                getColorTransformHash(layer),
+                getHdrMetadataHash(layer),
+        };
+        fingerprint.addLayer(key);
+    }
+    return fingerprint.get();
+}
+
+HistogramRoiTracker::Rect_t ExynosPrimaryDisplayModule::computeFrameDamage() {
+    const HistogramRoiTracker::Rect_t screen = {0, 0, static_cast<int32_t>(mXres),
+                                                static_cast<int32_t>(mYres)};
+    // layers added, removed or moved, or the stack was invalidated by a power or color mode
+    if (!mLayerStackFingerprint || mLayerStackFingerprint != mDamageFingerprint) {
+        mDamageFingerprint = mLayerStackFingerprint;
+        return screen;
+    }
+
+    HistogramRoiTracker::Rect_t damage = {};
+    for (size_t i = 0; i < mLayers.size(); i++) {
+        const ExynosLayer* layer = mLayers[i];
+        const hwc_rect_t& frame = layer->mDisplayFrame;
+        const HistogramRoiTracker::Rect_t frameRect = {frame.left, frame.top, frame.right,
+                                                       frame.bottom};
+        // no rects means the whole layer changed
+        if (!layer->mDamageNum) {
+            damage.unite(frameRect);
+            continue;
+        }
+
+        const hwc_frect_t& crop = layer->mSourceCrop;
+        float cropW = crop.right - crop.left;
+        float cropH = crop.bottom - crop.top;
+        for (const hwc_rect_t& rect : layer->mDamageRects) {
+            // a single [0, 0, 0, 0] rect means the content did not change
+            if (rect.right <= rect.left || rect.bottom <= rect.top) continue;
+            // the rects are in buffer space, only map them without a transform
+            if (layer->mTransform || cropW <= 0 || cropH <= 0) {
+                damage.unite(frameRect);
+                break;
+            }
+            float scaleX = (frame.right - frame.left) / cropW;
+            float scaleY = (frame.bottom - frame.top) / cropH;
+            HistogramRoiTracker::Rect_t mapped = {
+                    frame.left + static_cast<int32_t>(floorf((rect.left - crop.left) * scaleX)),
+                    frame.top + static_cast<int32_t>(floorf((rect.top - crop.top) * scaleY)),
+                    frame.left + static_cast<int32_t>(ceilf((rect.right - crop.left) * scaleX)),
+                    frame.top + static_cast<int32_t>(ceilf((rect.bottom - crop.top) * scaleY))};
+            mapped.left = std::max(mapped.left, frameRect.left);
+            mapped.top = std::max(mapped.top, frameRect.top);
+            mapped.right = std::min(mapped.right, frameRect.right);
+            mapped.bottom = std::min(mapped.bottom, frameRect.bottom);
+            damage.unite(mapped);
+        }
+    }
+    if (damage.isEmpty()) return {};
+
+    damage.left = std::max(damage.left, screen.left);
+    damage.top = std::max(damage.top, screen.top);
+    damage.right = std::min(damage.right, screen.right);
+    damage.bottom = std::min(damage.bottom, screen.bottom);
+    return damage.isEmpty() ? HistogramRoiTracker::Rect_t{} : damage;
+}
+
+const std::vector<uint8_t>& ExynosPrimaryDisplayModule::getDppFeatureMasks() const {
+    return mPreblendingCache.featureMasks;
+}
+
+void ExynosPrimaryDisplayModule::invalidateLayerStackCache() {
+    if (mLayerStackCache.valid) mLayerStackCache.invalidateCnt++;
+    mLayerStackCache.valid = false;
+    mLayerStackFingerprint = std::nullopt;
+    // the color settings may have changed the DPP state of every layer
+    mPreblendingCache.generation++;
+}
+
+void ExynosPrimaryDisplayModule::dumpLayerStackCache(String8& result) const {
+    const auto& cache = mLayerStackCache;
+    uint64_t total = cache.hitCnt + cache.missCnt;
+    result.appendFormat("Layer stack cache: hit %" PRIu64 "/%" PRIu64 " (%" PRIu64
+                        "%%), invalidated %" PRIu64 ", saved ~%" PRId64 " us\n",
+                        cache.hitCnt, total, total ? cache.hitCnt * 100 / total : 0,
+                        cache.invalidateCnt,
+                        cache.avgMissNs * static_cast<int64_t>(cache.hitCnt) / 1000);
+
+    const auto& layerCache = mPreblendingCache;
+    uint64_t checkCnt = layerCache.lookupCnt + layerCache.skipCnt;
+    result.appendFormat("Preblending cache: skipped %" PRIu64 "/%" PRIu64 " (%" PRIu64
+                        "%%) dpp lookups, generation %" PRIu64 ", %zu layers\n",
+                        layerCache.skipCnt, checkCnt,
+                        checkCnt ? layerCache.skipCnt * 100 / checkCnt : 0,
+                        layerCache.generation, layerCache.entries.size());
+}
+
 ExynosPrimaryDisplayModule::OperationRateManager::OperationRateManager(
-        ExynosPrimaryDisplay* display, int32_t hsHz, int32_t nsHz)
+        ExynosPrimaryDisplay* display, int32_t hsHz, int32_t nsHz, std::vector<int32_t> rates)
       : gs201::ExynosPrimaryDisplayModule::OperationRateManager(),
         mDisplay(display),
         mDisplayHsOperationRate(hsHz),
         mDisplayNsOperationRate(nsHz),
-        mDisplayPeakRefreshRate(0),
-        mDisplayRefreshRate(0),
-        mDisplayLastDbv(0),
-        mDisplayDbv(0),
         mDisplayHsSwitchMinDbv(0),
         mDisplayPowerMode(HWC2_POWER_MODE_ON),
-        mDisplayLowBatteryModeEnabled(false),
         mHistogramQueryWorker(nullptr) {
     mDisplayNsMinDbv = property_get_int32("vendor.primarydisplay.op.ns_min_dbv", 0);
-    mDisplayTargetOperationRate = mDisplayHsOperationRate;
-    OP_MANAGER_LOGI(mDisplay, "Op Rate: NS=%d HS=%d NsMinDbv=%d", mDisplayNsOperationRate,
-                    mDisplayHsOperationRate, mDisplayNsMinDbv);
+    mSettings = std::make_unique<DisplaySettingsStore>(std::vector<std::string>{
+            kPersistPeakRefreshRateProp, kVendorPeakRefreshRateProp});
+    std::string ratesStr;
+    for (int32_t rate : rates) ratesStr += std::to_string(rate) + " ";
+    OP_MANAGER_LOGI(mDisplay, "Op Rate: NS=%d HS=%d NsMinDbv=%d Rates=%s",
+                    mDisplayNsOperationRate, mDisplayHsOperationRate, mDisplayNsMinDbv,
+                    ratesStr.c_str());
 
     float histDeltaTh =
             static_cast<float>(property_get_int32("vendor.primarydisplay.op.hist_delta_th", 0));
     if (histDeltaTh) {
-        mHistogramQueryWorker = std::make_unique<HistogramQueryWorker>(this, histDeltaTh);
+        bool pushMode = property_get_bool("vendor.primarydisplay.op.hist_push", false);
+        bool adaptiveRoi = property_get_bool("vendor.primarydisplay.op.hist_adaptive", false);
+        mHistogramQueryWorker = std::make_unique<HistogramQueryWorker>(this, histDeltaTh, pushMode,
+                                                                       adaptiveRoi);
         mDisplayHsSwitchMinDbv =
                 property_get_int32("vendor.primarydisplay.op.hs_switch_min_dbv", 0);
     }
+    OperationRateController::Config_t config = {};
+    auto& policyConfig = config.policy;
+    policyConfig.rates = rates;
+    policyConfig.lowPowerRate = kLowPowerOperationRate;
+    policyConfig.nsMinDbv = mDisplayNsMinDbv;
+    policyConfig.hsSwitchMinDbv = mDisplayHsSwitchMinDbv;
+    policyConfig.brightnessDeltaUpThreshold =
+            property_get_int32("vendor.primarydisplay.op.dbv_delta_up_th",
+                               kBrightnessDeltaThreshold);
+    policyConfig.brightnessDeltaDownThreshold =
+            property_get_int32("vendor.primarydisplay.op.dbv_delta_down_th",
+                               kBrightnessDeltaThreshold);
+
+    auto& dwellConfig = config.dwell;
+    dwellConfig.highestRateMinNs = std::chrono::nanoseconds(std::chrono::milliseconds(
+            property_get_int32("vendor.primarydisplay.op.hs_min_dwell_ms", 0))).count();
+    dwellConfig.lowerRateMinNs = std::chrono::nanoseconds(std::chrono::milliseconds(
+            property_get_int32("vendor.primarydisplay.op.ns_min_dwell_ms", 0))).count();
+
+    auto& predictorConfig = config.dbvPredictor;
+    predictorConfig.horizonNs = std::chrono::nanoseconds(std::chrono::milliseconds(
+            property_get_int32("vendor.primarydisplay.op.dbv_predict_ms", 0))).count();
+    predictorConfig.maxStepNs = kDbvRampMaxStepNs;
+    config.hasHistogram = (mHistogramQueryWorker != nullptr);
+    OP_MANAGER_LOGI(mDisplay, "dbv delta up/down %d/%d, min dwell HS/NS %" PRId64 "/%" PRId64
+                    " ms", policyConfig.brightnessDeltaUpThreshold,
+                    policyConfig.brightnessDeltaDownThreshold,
+                    dwellConfig.highestRateMinNs / 1000000, dwellConfig.lowerRateMinNs / 1000000);
+    bool hasDwell = dwellConfig.highestRateMinNs || dwellConfig.lowerRateMinNs;
+    mController = std::make_unique<OperationRateController>(std::move(config));
+    if (hasDwell) mDwellTimer = std::make_unique<DwellTimerWorker>(this);
+    publishStateLocked();
+    // only the changes from the hooks are counted, not the initial state
+    mTelemetry = std::make_unique<OperationRateTelemetry>(rates, kLowPowerOperationRate,
+                                                          systemTime(SYSTEM_TIME_MONOTONIC));
 }
 
 ExynosPrimaryDisplayModule::OperationRateManager::~OperationRateManager() {}
 
+bool ExynosPrimaryDisplayModule::OperationRateManager::needsFrameDamage() const {
+    return mHistogramQueryWorker && mHistogramQueryWorker->isAdaptiveRoi();
+}
+
+void ExynosPrimaryDisplayModule::OperationRateManager::onFrameUpdate(
+        const HistogramRoiTracker::Rect_t& damage) {
+    if (mHistogramQueryWorker) mHistogramQueryWorker->onFrameUpdate(damage);
+
+    // the frame may come before the dwell timer, skip it rather than wait for a hook
+    if (applyExpiredDwell(false)) mDisplay->handleTargetOperationRate();
+}
+
+bool ExynosPrimaryDisplayModule::OperationRateManager::applyExpiredDwell(bool wait) {
+    if (mController->getDwellWaitNs(systemTime(SYSTEM_TIME_MONOTONIC)) != 0) return false;
+    if (wait) {
+        mLock.lock();
+    } else if (mLock.tryLock() != NO_ERROR) {
+        return false;
+    }
+    // another thread may have applied it or held a new switch meanwhile
+    bool due = mController->getDwellWaitNs(systemTime(SYSTEM_TIME_MONOTONIC)) == 0;
+    if (due) {
+        updateOperationRateLocked(DispOpCondition::DWELL_EXPIRED);
+        publishStateLocked();
+    }
+    mLock.unlock();
+    return due;
+}
+
+ExynosPrimaryDisplayModule::OperationRateManager::DwellTimerWorker::DwellTimerWorker(
+        OperationRateManager* opRateManager)
+      : Worker("DwellTimerWorker", HAL_PRIORITY_URGENT_DISPLAY),
+        mOpRateManager(opRateManager) {
+    InitWorker();
+}
+
+ExynosPrimaryDisplayModule::OperationRateManager::DwellTimerWorker::~DwellTimerWorker() {
+    Exit();
+}
+
+void ExynosPrimaryDisplayModule::OperationRateManager::DwellTimerWorker::arm() {
+    // Signal() under the lock, so a Routine() between its check and its wait sees it
+    Lock();
+    Signal();
+    Unlock();
+}
+
+void ExynosPrimaryDisplayModule::OperationRateManager::DwellTimerWorker::Routine() {
+    int ret = 0;
+    Lock();
+    int64_t waitNs =
+            mOpRateManager->mController->getDwellWaitNs(systemTime(SYSTEM_TIME_MONOTONIC));
+    if (waitNs) ret = WaitForSignalOrExitLocked(waitNs);
+    Unlock();
+    if (ret == -EINTR) return;
+
+    // woken up early by arm() for a new deadline, or the held switch is due
+    if (mOpRateManager->applyExpiredDwell(true)) {
+        mOpRateManager->mDisplay->handleTargetOperationRate();
+    }
+}
+
+void ExynosPrimaryDisplayModule::OperationRateManager::onFramePresented() {
+    if (mHistogramQueryWorker) mHistogramQueryWorker->onFramePresented();
+}
+
+void ExynosPrimaryDisplayModule::OperationRateManager::dump(String8& result) const {
+    State_t state = mState.load();
+    result.appendFormat("Operation rate: target %d, refresh %d, peak %d, dbv %d\n",
+                        state.targetOperationRate, state.refreshRate, state.peakRefreshRate,
+                        state.dbv);
+    auto controllerStats = mController->getStats();
+    result.appendFormat("\theld by dwell %" PRIu64 " (applied later %" PRIu64
+                        "), held by hysteresis %" PRIu64 "\n",
+                        controllerStats.dwellHeldCnt, controllerStats.dwellAppliedCnt,
+                        controllerStats.hysteresisHeldCnt);
+
+    OperationRateStats_t stats;
+    getStats(&stats);
+    double durationSec = stats.durationNs / 1e9;
+    result.appendFormat("\tresidency over %.1f s:", durationSec);
+    for (size_t i = 0; i < stats.rateCnt; i++) {
+        if (!stats.residencyNs[i]) continue;
+        double percent = stats.residencyNs[i] * 100.0 / stats.durationNs;
+        if (stats.rates[i] < 0) {
+            result.appendFormat(" other %.1f%%", percent);
+        } else {
+            result.appendFormat(" %d %.1f%%", stats.rates[i], percent);
+        }
+    }
+    result.appendFormat("\n\tswitches (left lowest) by");
+    for (size_t i = 0; i < OperationRateStats_t::kConditionCnt; i++) {
+        result.appendFormat(" %s %" PRIu64 " (%" PRIu64 ")", kConditionNames[i],
+                            stats.switchCnt[i], stats.leaveLowestCnt[i]);
+    }
+    constexpr size_t kHistogramCond = static_cast<size_t>(DispOpCondition::HISTOGRAM_DELTA);
+    result.appendFormat(", histogram switches %.1f/h\n",
+                        durationSec ? stats.switchCnt[kHistogramCond] * 3600 / durationSec : 0);
+    result.appendFormat("\tapply latency: cnt %" PRIu64 ", avg %.2f ms, max %.2f ms, <2^i ms:",
+                        stats.latencyCnt,
+                        stats.latencyCnt ? stats.latencyTotalNs / 1e6 / stats.latencyCnt : 0,
+                        stats.latencyMaxNs / 1e6);
+    for (uint64_t count : stats.latencyBuckets) result.appendFormat(" %" PRIu64, count);
+    result.appendFormat("\n");
+    if (mHistogramQueryWorker) mHistogramQueryWorker->dump(result);
+    mSettings->dump(result);
+
+    if (!mController->getDbvPredictor().isEnabled()) return;
+    DbvTrendPredictor::Stats_t predictor;
+    {
+        // onBrightness() updates the counters under the lock
+        Mutex::Autolock lock(mLock);
+        predictor = mController->getDbvPredictor().getStats();
+    }
+    result.appendFormat("\tdbv ramp prediction: predicted %" PRIu64 ", hit %" PRIu64
+                        ", false alarm %" PRIu64 ", missed %" PRIu64 ", avg lead %" PRId64
+                        " ms\n",
+                        predictor.predictedCnt, predictor.hitCnt, predictor.falseAlarmCnt,
+                        predictor.missedCnt,
+                        predictor.hitCnt ? predictor.totalLeadNs /
+                                        static_cast<int64_t>(predictor.hitCnt) / 1000000
+                                         : 0);
+}
+
+void ExynosPrimaryDisplayModule::OperationRateManager::getStats(OperationRateStats_t* stats) const {
+    Mutex::Autolock lock(mLock);
+    mTelemetry->getStats(stats, systemTime(SYSTEM_TIME_MONOTONIC));
+}
+
 int32_t ExynosPrimaryDisplayModule::OperationRateManager::getTargetOperationRate() const {
-    if (mDisplayPowerMode == HWC2_POWER_MODE_DOZE ||
-        mDisplayPowerMode == HWC2_POWER_MODE_DOZE_SUSPEND) {
+    // called from the present path, must not wait for the hooks
+    if (mTelemetry && mTelemetry->isApplyPending()) {
+        mTelemetry->onRateApplied(systemTime(SYSTEM_TIME_MONOTONIC));
+    }
+    State_t state = mState.load();
+    if (state.powerMode == HWC2_POWER_MODE_DOZE ||
+        state.powerMode == HWC2_POWER_MODE_DOZE_SUSPEND) {
         return kLowPowerOperationRate;
     } else {
-        return mDisplayTargetOperationRate;
+        return state.targetOperationRate;
     }
 }
 
-int32_t ExynosPrimaryDisplayModule::OperationRateManager::onPeakRefreshRate(uint32_t rate) {
-    char rateStr[PROP_VALUE_MAX];
-    std::sprintf(rateStr, "%d", rate);
+ExynosPrimaryDisplayModule::OperationRateManager::State_t
+ExynosPrimaryDisplayModule::OperationRateManager::getState(uint32_t* version) const {
+    return mState.load(version);
+}
+
+void ExynosPrimaryDisplayModule::OperationRateManager::publishStateLocked() {
+    State_t state = {};
+    state.dbv = mController->getDbv();
+    state.refreshRate = mController->getRefreshRate();
+    state.peakRefreshRate = mController->getPeakRefreshRate();
+    state.powerMode = mDisplayPowerMode ? *mDisplayPowerMode : kPowerModeUnknown;
+    state.lowBatteryMode = mController->isLowBatteryMode();
+    state.targetOperationRate = mController->getTargetRate();
+    mState.store(state);
+
+    if (mTelemetry) {
+        mTelemetry->onRateChanged(mController->getOperationRate(), mLastCondition,
+                                  systemTime(SYSTEM_TIME_MONOTONIC));
+    }
+}
 
+int32_t ExynosPrimaryDisplayModule::OperationRateManager::onPeakRefreshRate(uint32_t rate) {
     DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate, "OperationRateManager: rate=%d",
                      rate);
 
+    // persisted on the store thread
+    mSettings->setInt32(kPersistPeakRefreshRateProp, rate);
     Mutex::Autolock lock(mLock);
-    if (property_set("persist.vendor.primarydisplay.op.peak_refresh_rate", rateStr) < 0) {
-        OP_MANAGER_LOGE(mDisplay,
-                        "failed to set property persist.primarydisplay.op.peak_refresh_rate");
-    }
-    mDisplayPeakRefreshRate = rate;
+    mController->setPeakRefreshRate(rate);
+    publishStateLocked();
     return 0;
 }
 
@@ -112,7 +544,8 @@ int32_t ExynosPrimaryDisplayModule::OperationRateManager::onLowPowerMode(bool en
     DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate, "enabled=%d", enabled);
 
     Mutex::Autolock lock(mLock);
-    mDisplayLowBatteryModeEnabled = enabled;
+    mController->setLowBatteryMode(enabled);
+    publishStateLocked();
     return 0;
 }
 
@@ -120,48 +553,49 @@ int32_t ExynosPrimaryDisplayModule::OperationRateManager::onConfig(hwc2_config_t
     Mutex::Autolock lock(mLock);
     int32_t targetRefreshRate = mDisplay->getRefreshRate(cfg);
     if (mHistogramQueryWorker && mHistogramQueryWorker->isRuntimeResolutionConfig() &&
-        mDisplayRefreshRate == targetRefreshRate) {
+        mController->getRefreshRate() == targetRefreshRate) {
         mHistogramQueryWorker->updateConfig(mDisplay->mXres, mDisplay->mYres);
         // skip op update for Runtime Resolution config
         return 0;
     }
-    mDisplayRefreshRate = targetRefreshRate;
+    mController->setRefreshRate(targetRefreshRate);
     DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate, "OperationRateManager: rate=%d",
-                     mDisplayRefreshRate);
+                     targetRefreshRate);
     updateOperationRateLocked(DispOpCondition::SET_CONFIG);
+    publishStateLocked();
     return 0;
 }
 
 int32_t ExynosPrimaryDisplayModule::OperationRateManager::onBrightness(uint32_t dbv) {
     Mutex::Autolock lock(mLock);
-    if (dbv == 0 || mDisplayLastDbv == dbv) return 0;
+    if (!mController->setDbv(dbv, systemTime(SYSTEM_TIME_MONOTONIC))) return 0;
     DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate, "OperationRateManager: dbv=%d", dbv);
-    mDisplayDbv = dbv;
 
     /*
         Update peak_refresh_rate from persist/vendor prop after a brightness change.
         1. Otherwise there will be NS-HS-NS switch during the onPowerMode.
         2. When constructor is called, persist property is not ready yet and returns 0.
+           The store only reports loaded once it is, until then keep trying.
     */
-    if (!mDisplayPeakRefreshRate) {
-        char rateStr[PROP_VALUE_MAX];
-        int32_t vendorPeakRefreshRate = 0, persistPeakRefreshRate = 0;
-        if (property_get("persist.vendor.primarydisplay.op.peak_refresh_rate", rateStr, "0") >= 0 &&
-            atoi(rateStr) > 0) {
-            persistPeakRefreshRate = atoi(rateStr);
-            mDisplayPeakRefreshRate = persistPeakRefreshRate;
+    if (!mController->getPeakRefreshRate() && mSettings->isLoaded()) {
+        int32_t vendorPeakRefreshRate = 0;
+        int32_t persistPeakRefreshRate = mSettings->getInt32(kPersistPeakRefreshRateProp, 0);
+        if (persistPeakRefreshRate > 0) {
+            mController->setPeakRefreshRate(persistPeakRefreshRate);
         } else {
-            vendorPeakRefreshRate =
-                    property_get_int32("vendor.primarydisplay.op.peak_refresh_rate", 0);
-            mDisplayPeakRefreshRate = vendorPeakRefreshRate;
+            vendorPeakRefreshRate = mSettings->getInt32(kVendorPeakRefreshRateProp, 0);
+            mController->setPeakRefreshRate(vendorPeakRefreshRate);
         }
 
         DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate,
                          "OperationRateManager: peak_refresh_rate=%d[vendor: %d|persist %d]",
-                         mDisplayPeakRefreshRate, vendorPeakRefreshRate, persistPeakRefreshRate);
+                         mController->getPeakRefreshRate(), vendorPeakRefreshRate,
+                         persistPeakRefreshRate);
     }
 
-    return updateOperationRateLocked(DispOpCondition::SET_DBV);
+    int32_t ret = updateOperationRateLocked(DispOpCondition::SET_DBV);
+    publishStateLocked();
+    return ret;
 }
 
 int32_t ExynosPrimaryDisplayModule::OperationRateManager::onPowerMode(int32_t mode) {
@@ -179,130 +613,72 @@ int32_t ExynosPrimaryDisplayModule::OperationRateManager::onPowerMode(int32_t mo
 
     Mutex::Autolock lock(mLock);
     mDisplayPowerMode = static_cast<hwc2_power_mode_t>(mode);
-    return updateOperationRateLocked(DispOpCondition::PANEL_SET_POWER);
+    if (mode == HWC2_POWER_MODE_ON) {
+        mController->setPowerState(OperationRatePolicy::PowerState::ON);
+    } else if (mode == HWC2_POWER_MODE_DOZE || mode == HWC2_POWER_MODE_DOZE_SUSPEND) {
+        mController->setPowerState(OperationRatePolicy::PowerState::LP);
+    } else {
+        mController->setPowerState(OperationRatePolicy::PowerState::OFF);
+    }
+    int32_t ret = updateOperationRateLocked(DispOpCondition::PANEL_SET_POWER);
+    publishStateLocked();
+    return ret;
 }
 
 int32_t ExynosPrimaryDisplayModule::OperationRateManager::onHistogram() {
     Mutex::Autolock lock(mLock);
     DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate,
                      "histogram reach to the luma delta threshold");
-    return updateOperationRateLocked(DispOpCondition::HISTOGRAM_DELTA);
+    int32_t ret = updateOperationRateLocked(DispOpCondition::HISTOGRAM_DELTA);
+    publishStateLocked();
+    return ret;
 }
 
 int32_t ExynosPrimaryDisplayModule::OperationRateManager::updateOperationRateLocked(
         const DispOpCondition cond) {
-    int32_t ret = HWC2_ERROR_NONE, dbv;
-
     ATRACE_CALL();
-    if (cond == DispOpCondition::SET_DBV) {
-        dbv = mDisplayDbv;
-    } else {
-        dbv = mDisplayLastDbv;
-    }
-
-    int32_t desiredOpRate = mDisplayHsOperationRate;
-    bool isSteadyLowRefreshRate =
-            (mDisplayPeakRefreshRate && mDisplayPeakRefreshRate <= mDisplayNsOperationRate) ||
-            mDisplayLowBatteryModeEnabled;
-    bool isDbvInBlockingZone = mDisplayLowBatteryModeEnabled ? (dbv < mDisplayNsMinDbv)
-                                                             : (dbv < mDisplayHsSwitchMinDbv);
-    int32_t effectiveOpRate = 0;
+    mLastCondition = cond;
+    auto update = mController->update(cond, mDisplay->isConfigSettingEnabled(),
+                                      systemTime(SYSTEM_TIME_MONOTONIC));
+    const auto& decision = update.decision;
 
-    // check minimal operation rate needed
-    if (isSteadyLowRefreshRate && mDisplayRefreshRate <= mDisplayNsOperationRate) {
-        desiredOpRate = mDisplayNsOperationRate;
+    if (update.heldRate) {
+        DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate,
+                         "OperationRateManager: hold %d->%d for %" PRId64 " us",
+                         mController->getTargetRate(), update.heldRate, update.heldNs / 1000);
+        if (mDwellTimer) mDwellTimer->arm();
     }
-    // check blocking zone
-    if (isDbvInBlockingZone) {
+    if (decision.blocking) {
         DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate,
-                         "OperationRateManager: in blocking zone (dbv %d, min %d)", dbv,
+                         "OperationRateManager: in blocking zone (dbv %d, min %d)", update.dbv,
                          mDisplayNsMinDbv);
-        desiredOpRate = mDisplayHsOperationRate;
-    }
-
-    if (mDisplayPowerMode == HWC2_POWER_MODE_DOZE ||
-        mDisplayPowerMode == HWC2_POWER_MODE_DOZE_SUSPEND) {
-        mDisplayTargetOperationRate = kLowPowerOperationRate;
-        desiredOpRate = mDisplayTargetOperationRate;
-        effectiveOpRate = desiredOpRate;
-    } else if (mDisplayPowerMode != HWC2_POWER_MODE_ON) {
-        if (mHistogramQueryWorker) {
-            DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate,
-                             "histogram stopQuery due to power off");
-            mHistogramQueryWorker->stopQuery();
-        }
-        return ret;
-    }
-
-    if (cond == DispOpCondition::SET_CONFIG) {
-        if (mDisplayRefreshRate <= mDisplayHsOperationRate) {
-            if (!mHistogramQueryWorker) {
-                if (mDisplayRefreshRate > mDisplayNsOperationRate) {
-                    effectiveOpRate = mDisplayHsOperationRate;
-                }
-            } else {
-                if (mDisplayRefreshRate == mDisplayTargetOperationRate && !isDbvInBlockingZone) {
-                    DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate,
-                                     "histogram stopQuery due to the same config");
-                    mHistogramQueryWorker->stopQuery();
-                }
-                if (!isDbvInBlockingZone) {
-                    if (mDisplayLowBatteryModeEnabled &&
-                        (!mDisplayHsSwitchMinDbv || dbv < mDisplayHsSwitchMinDbv)) {
-                        // delay the switch of NS->HS until conditions are satisfied
-                        desiredOpRate = mDisplayRefreshRate;
-                    } else if (mDisplayRefreshRate > mDisplayNsOperationRate) {
-                        // will switch to HS immediately
-                        effectiveOpRate = mDisplayHsOperationRate;
-                    }
-                }
-            }
-        }
-    } else if (cond == DispOpCondition::PANEL_SET_POWER) {
-        if (mDisplayPowerMode == HWC2_POWER_MODE_ON) {
-            mDisplayTargetOperationRate = getTargetOperationRate();
-        }
-        effectiveOpRate = desiredOpRate;
-    } else if (cond == DispOpCondition::SET_DBV) {
-        // TODO: tune brightness delta for different brightness curve and values
-        int32_t delta = abs(dbv - mDisplayLastDbv);
-        if (!mHistogramQueryWorker) {
-            if (desiredOpRate == mDisplayHsOperationRate || delta > kBrightnessDeltaThreshold) {
-                effectiveOpRate = desiredOpRate;
-            }
-        } else {
-            if (delta > kBrightnessDeltaThreshold) {
-                effectiveOpRate = desiredOpRate;
-                DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate,
-                                 "histogram stopQuery due to dbv delta");
-                mHistogramQueryWorker->stopQuery();
-            }
-        }
-        mDisplayLastDbv = dbv;
-        if (effectiveOpRate > kLowPowerOperationRate &&
-            (effectiveOpRate != mDisplayTargetOperationRate)) {
-            DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate,
-                             "OperationRateManager: brightness delta=%d", delta);
-        } else {
-            if (!mHistogramQueryWorker ||
-                (desiredOpRate == mDisplayNsOperationRate && isDbvInBlockingZone)) {
-                return ret;
-            }
-        }
-    } else if (cond == DispOpCondition::HISTOGRAM_DELTA) {
-        effectiveOpRate = desiredOpRate;
+    }
+    if (decision.stopQuery) {
+        DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate,
+                         "histogram stopQuery due to %s", decision.stopReason);
+        mHistogramQueryWorker->stopQuery();
+    }
+    if (decision.outcome == OperationRatePolicy::Outcome::POWER_OFF) return HWC2_ERROR_NONE;
+
+    if (decision.updateLastDbv && decision.targetChanged) {
+        DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate,
+                         "OperationRateManager: brightness delta=%d", update.dbvDelta);
     }
 
-    if (!mDisplay->isConfigSettingEnabled() && effectiveOpRate == mDisplayNsOperationRate) {
-        OP_MANAGER_LOGI(mDisplay, "rate switching is disabled, skip NS op rate update");
-        return ret;
-    } else if (effectiveOpRate > kLowPowerOperationRate &&
-               effectiveOpRate != mDisplayTargetOperationRate) {
-        mDisplayTargetOperationRate = effectiveOpRate;
-        OP_MANAGER_LOGI(mDisplay, "set target operation rate %d", effectiveOpRate);
+    switch (decision.outcome) {
+        case OperationRatePolicy::Outcome::NO_CHANGE:
+            return HWC2_ERROR_NONE;
+        case OperationRatePolicy::Outcome::SWITCH_DISABLED:
+            OP_MANAGER_LOGI(mDisplay, "rate switching is disabled, skip lower op rate update");
+            return HWC2_ERROR_NONE;
+        default:
+            break;
     }
 
-    if (mHistogramQueryWorker && mDisplayTargetOperationRate != desiredOpRate) {
+    if (decision.targetChanged) {
+        OP_MANAGER_LOGI(mDisplay, "set target operation rate %d", decision.targetRate);
+    }
+    if (decision.startQuery) {
         DISPLAY_STR_LOGD(DISP_STR(mDisplay), eDebugOperationRate, "histogram startQuery");
         mHistogramQueryWorker->startQuery();
     }
@@ -310,54 +686,191 @@ int32_t ExynosPrimaryDisplayModule::OperationRateManager::updateOperationRateLoc
     OP_MANAGER_LOGI(mDisplay,
                     "Target@%d(desired:%d) | Refresh@%d(peak:%d), Battery:%s, DBV:%d(NsMin:%d, "
                     "HsSwitchMin:%d)",
-                    mDisplayTargetOperationRate, desiredOpRate, mDisplayRefreshRate,
-                    mDisplayPeakRefreshRate, mDisplayLowBatteryModeEnabled ? "Low" : "OK",
-                    mDisplayLastDbv, mDisplayNsMinDbv, mDisplayHsSwitchMinDbv);
-    return ret;
+                    mController->getTargetRate(), decision.desiredRate,
+                    mController->getRefreshRate(), mController->getPeakRefreshRate(),
+                    mController->isLowBatteryMode() ? "Low" : "OK", mController->getLastDbv(),
+                    mDisplayNsMinDbv, mDisplayHsSwitchMinDbv);
+    return HWC2_ERROR_NONE;
 }
 
 void ExynosPrimaryDisplayModule::checkPreblendingRequirement() {
+    updatePreblendingRequirement();
+    // the TDM checks of the assignment depend on the preblending decision
+    auto* resourceManager = static_cast<ExynosResourceManagerModule*>(mDevice->mResourceManager);
+    resourceManager->prepareAssign(this, mLayerStackFingerprint, getDppFeatureMasks());
+}
+
+void ExynosPrimaryDisplayModule::finishDisplayColorPreload() {
+    if (!mDisplayColorPreloader) return;
+    switch (mDisplayColorPreloader->getState()) {
+        case DisplayColorPreloader::State::LOADING:
+            return;
+        case DisplayColorPreloader::State::READY:
+            DISPLAY_LOGI("%s: %s mapped in %" PRId64 " ms off the init path", __func__,
+                         DISPLAY_COLOR_LIB, mDisplayColorPreloader->getLoadNs() / 1000000);
+            break;
+        case DisplayColorPreloader::State::FAILED:
+            DISPLAY_LOGW("%s: failed to preload %s: %s", __func__, DISPLAY_COLOR_LIB,
+                         mDisplayColorPreloader->getError().c_str());
+            break;
+    }
+    // the device module holds its own reference on the library
+    mDisplayColorPreloader.reset();
+}
+
+void ExynosPrimaryDisplayModule::updatePreblendingRequirement() {
+    uint64_t fingerprint = computeLayerStackFingerprint();
+    auto& cache = mLayerStackCache;
+    mLayerStackFingerprint = fingerprint;
+
+    finishDisplayColorPreload();
+
     if (!hasDisplayColor()) {
         DISPLAY_LOGD(eDebugTDM, "%s is skipped because of no displaycolor", __func__);
+        mPreblendingCache.featureMasks.clear();
+        return;
+    }
+
+    if (cache.valid && cache.fingerprint == fingerprint &&
+        cache.layerNeedPreblending.size() == mLayers.size()) {
+        // the feature masks are still the ones resolved for this layer stack
+        cache.hitCnt++;
+        mClientCompositionInfo.mNeedPreblending = cache.clientNeedPreblending;
+        for (size_t i = 0; i < mLayers.size(); ++i) {
+            mLayers[i]->mNeedPreblending = cache.layerNeedPreblending[i];
+        }
+        DISPLAY_LOGD(eDebugTDM, "disp(%d),layer stack cache hit", mDisplayId);
+        return;
+    }
+
+    auto* colorManager = getColorManager();
+    if (!colorManager) {
+        mPreblendingCache.featureMasks.clear();
         return;
     }
 
+    int64_t startNs = systemTime(SYSTEM_TIME_MONOTONIC);
     String8 log;
     int count = 0;
+    int skipped = 0;
+    auto& layerCache = mPreblendingCache;
+    layerCache.frame++;
 
-    auto checkPreblending = [&](const int idx, ExynosMPPSource* mppSrc) -> int {
-        auto* colorManager = getColorManager();
-        if (!colorManager) return false;
-        auto& dpp = colorManager->getDppForLayer(mppSrc);
-        mppSrc->mNeedPreblending =
-                dpp.EotfLut().enable | dpp.Gm().enable | dpp.Dtm().enable | dpp.OetfLut().enable;
-        if (hwcCheckDebugMessages(eDebugTDM)) {
-            log.appendFormat(" i=%d,pb(%d-%d,%d,%d,%d)", idx, mppSrc->mNeedPreblending,
-                             dpp.EotfLut().enable, dpp.Gm().enable, dpp.Dtm().enable,
-                             dpp.OetfLut().enable);
-        }
-        return mppSrc->mNeedPreblending;
+    // index 0 is the client target, i + 1 is mLayers[i]
+    auto getSource = [&](const size_t idx) -> ExynosMPPSource* {
+        return idx ? static_cast<ExynosMPPSource*>(mLayers[idx - 1]) : &mClientCompositionInfo;
+    };
+    auto getDataspace = [&](const size_t idx) -> int32_t {
+        return static_cast<int32_t>(idx ? mLayers[idx - 1]->mDataSpace
+                                        : mClientCompositionInfo.mDataSpace);
     };
+    // the per layer inputs of the DPP state besides the dataspace, none for the client target
+    auto getColorState = [&](const size_t idx) -> uint64_t {
+        if (!idx) return 0;
+        const ExynosLayer* layer = mLayers[idx - 1];
+        uint32_t brightness;
+        memcpy(&brightness, &layer->mBrightness, sizeof(brightness));
+        const uint64_t state[] = {getColorTransformHash(layer), getHdrMetadataHash(layer),
+                                  brightness, layer->mIsHdrLayer};
+        return LayerStackFingerprint::hashBytes(state, sizeof(state));
+    };
+    auto getKey = [&](const size_t idx) -> PreblendingCache::Key {
+        if (!idx) return {PreblendingCache::kClientTargetId, layerCache.generation};
+        auto [id, added] = layerCache.layerIds.try_emplace(getSource(idx), 0);
+        if (added) id->second = layerCache.nextLayerId++;
+        return {id->second, layerCache.generation};
+    };
+
+    // take what the color settings already decided, look up the rest layer by layer
+    auto& masks = layerCache.featureMasks;
+    masks.assign(mLayers.size() + 1, DPP_FEATURE_UNKNOWN);
+    auto& colorStates = layerCache.colorStates;
+    colorStates.resize(masks.size());
+    for (size_t idx = 0; idx < masks.size(); ++idx) {
+        colorStates[idx] = getColorState(idx);
+        auto it = layerCache.entries.find(getKey(idx));
+        if (it != layerCache.entries.end() && it->second.dataspace == getDataspace(idx) &&
+            it->second.colorState == colorStates[idx]) {
+            masks[idx] = it->second.featureMask;
+            skipped++;
+        }
+    }
+    layerCache.skipCnt += skipped;
+    layerCache.lookupCnt += masks.size() - skipped;
+    if (static_cast<size_t>(skipped) < masks.size()) {
+        lookupDppFeatureMasks(*colorManager, &mClientCompositionInfo, mLayers, &masks);
+    }
 
-    // for client target
-    count += checkPreblending(-1, &mClientCompositionInfo);
+    for (size_t idx = 0; idx < masks.size(); ++idx) {
+        ExynosMPPSource* mppSrc = getSource(idx);
+        auto& entry = layerCache.entries[getKey(idx)];
+        entry.frame = layerCache.frame;
+        entry.dataspace = getDataspace(idx);
+        entry.colorState = colorStates[idx];
+        entry.featureMask = masks[idx];
+        mppSrc->mNeedPreblending = masks[idx] != 0;
+        count += mppSrc->mNeedPreblending;
+        if (hwcCheckDebugMessages(eDebugTDM)) {
+            log.appendFormat(" i=%d,pb(%d-%d,%d,%d,%d)", static_cast<int>(idx) - 1,
+                             mppSrc->mNeedPreblending, !!(masks[idx] & DPP_FEATURE_EOTF),
+                             !!(masks[idx] & DPP_FEATURE_GM), !!(masks[idx] & DPP_FEATURE_DTM),
+                             !!(masks[idx] & DPP_FEATURE_OETF));
+        }
+    }
+    for (auto it = layerCache.entries.begin(); it != layerCache.entries.end();) {
+        it = it->second.frame == layerCache.frame ? std::next(it) : layerCache.entries.erase(it);
+    }
+    // every layer of the display is in mLayers until it is destroyed
+    if (layerCache.layerIds.size() > mLayers.size()) {
+        for (auto it = layerCache.layerIds.begin(); it != layerCache.layerIds.end();) {
+            bool live = false;
+            for (size_t i = 0; i < mLayers.size() && !live; ++i) live = it->first == mLayers[i];
+            it = live ? std::next(it) : layerCache.layerIds.erase(it);
+        }
+    }
+    DISPLAY_LOGD(eDebugTDM, "disp(%d),cnt=%d,reused=%d%s", mDisplayId, count, skipped,
+                 log.c_str());
 
-    // for normal layers
+    cache.clientNeedPreblending = mClientCompositionInfo.mNeedPreblending;
+    cache.layerNeedPreblending.resize(mLayers.size());
     for (size_t i = 0; i < mLayers.size(); ++i) {
-        count += checkPreblending(i, mLayers[i]);
+        cache.layerNeedPreblending[i] = mLayers[i]->mNeedPreblending;
     }
-    DISPLAY_LOGD(eDebugTDM, "disp(%d),cnt=%d%s", mDisplayId, count, log.c_str());
+    cache.fingerprint = fingerprint;
+    cache.valid = true;
+    cache.missCnt++;
+
+    int64_t costNs = systemTime(SYSTEM_TIME_MONOTONIC) - startNs;
+    cache.avgMissNs = cache.avgMissNs ? (cache.avgMissNs * 7 + costNs) / 8 : costNs;
 }
 
 ExynosPrimaryDisplayModule::OperationRateManager::HistogramQueryWorker::HistogramQueryWorker(
-        OperationRateManager* opRateManager, float deltaThreshold)
+        OperationRateManager* opRateManager, float deltaThreshold, bool pushMode,
+        bool adaptiveRoi)
       : Worker("HistogramQueryWorker", HAL_PRIORITY_URGENT_DISPLAY),
         mOpRateManager(opRateManager),
+        mPushMode(pushMode),
         mSpAIBinder(nullptr),
         mReady(false),
         mQueryMode(false),
         mHistogramLumaDeltaThreshold(deltaThreshold),
-        mPrevHistogramLuma(0) {
+        mPrevHistogramLuma(0),
+        mHistogramStats{},
+        mRoiTracker(nullptr),
+        mRoi{},
+        mPrevRoiLuma(0),
+        mRegisteredXres(0),
+        mRegisteredYres(0) {
+    if (adaptiveRoi) {
+        HistogramRoiTracker::Config_t config;
+        config.stableFrames = kRoiStableFrames;
+        config.maxAreaPercent = kRoiMaxAreaPercent;
+        config.basePeriodNs = kQueryPeriodNanosecs;
+        config.maxPeriodNs = kQueryMaxPeriodNanosecs;
+        mRoiTracker = std::make_unique<HistogramRoiTracker>(config);
+    }
+    OP_MANAGER_LOGI(mOpRateManager->mDisplay, "histogram %s mode%s",
+                    mPushMode ? "push" : "polling", adaptiveRoi ? ", adaptive roi" : "");
     InitWorker();
 }
 
@@ -414,6 +927,9 @@ void ExynosPrimaryDisplayModule::OperationRateManager::HistogramQueryWorker::pre
     // assign panel resolution for isRuntimeResolutionConfig()
     mConfig.roi.right = mOpRateManager->mDisplay->mXres;
     mConfig.roi.bottom = mOpRateManager->mDisplay->mYres;
+    mRegisteredXres = mOpRateManager->mDisplay->mXres;
+    mRegisteredYres = mOpRateManager->mDisplay->mYres;
+    mRoi = {};
     mReady = true;
     OP_MANAGER_LOGI(mOpRateManager->mDisplay, "register histogram successfully");
 }
@@ -460,6 +976,54 @@ void ExynosPrimaryDisplayModule::OperationRateManager::HistogramQueryWorker::sto
     mQueryMode = false;
 }
 
+bool ExynosPrimaryDisplayModule::OperationRateManager::HistogramQueryWorker::reconfigRoi(
+        const HistogramRoiTracker::Rect_t& roi) {
+    // mConfig keeps the registered config, (0, 0, 0, 0) is full screen
+    HistogramDevice::HistogramConfig config = mConfig;
+    config.roi.left = roi.left;
+    config.roi.top = roi.top;
+    config.roi.right = roi.right;
+    config.roi.bottom = roi.bottom;
+
+    HistogramDevice::HistogramErrorCode err = HistogramDevice::HistogramErrorCode::NONE;
+    ndk::ScopedAStatus status =
+            mOpRateManager->mDisplay->mHistogramController->reconfigHistogram(mSpAIBinder,
+                                                                              config, &err);
+    if (!status.isOk() || err != HistogramDevice::HistogramErrorCode::NONE) {
+        OP_MANAGER_LOGE(mOpRateManager->mDisplay, "failed to reconfig histogram roi");
+        mRoiTracker->disableRoi();
+        return false;
+    }
+    DISPLAY_STR_LOGD(DISP_STR(mOpRateManager->mDisplay), eDebugOperationRate,
+                     "histogram roi [%d, %d, %d, %d]", roi.left, roi.top, roi.right, roi.bottom);
+    mRoi = roi;
+    return true;
+}
+
+void ExynosPrimaryDisplayModule::OperationRateManager::HistogramQueryWorker::onFrameUpdate(
+        const HistogramRoiTracker::Rect_t& damage) {
+    if (mRoiTracker) {
+        ExynosPrimaryDisplay* display = mOpRateManager->mDisplay;
+        HistogramRoiTracker::Rect_t rect = damage;
+        // the roi would need scaling under a runtime resolution, keep it full screen
+        if (!rect.isEmpty() &&
+            (display->mXres != mRegisteredXres || display->mYres != mRegisteredYres)) {
+            rect = {0, 0, static_cast<int32_t>(display->mXres),
+                    static_cast<int32_t>(display->mYres)};
+        }
+        bool wake = mRoiTracker->onFrame(rect, display->mXres, display->mYres);
+        // a backed off polling worker would see the change late
+        if (wake && !mPushMode && mReady && mQueryMode) Signal();
+    }
+}
+
+void ExynosPrimaryDisplayModule::OperationRateManager::HistogramQueryWorker::onFramePresented() {
+    // the histogram only changes with a new frame, query it once per frame while active
+    if (!mPushMode || !mReady || !mQueryMode) return;
+
+    Signal();
+}
+
 void ExynosPrimaryDisplayModule::OperationRateManager::HistogramQueryWorker::Routine() {
     if (!mOpRateManager->mDisplay->mHistogramController) return;
 
@@ -477,8 +1041,12 @@ void ExynosPrimaryDisplayModule::OperationRateManager::HistogramQueryWorker::Rou
         ret = WaitForSignalOrExitLocked();
         mQueryMode = true;
         mPrevHistogramLuma = 0;
+        if (mRoiTracker) mRoiTracker->reset();
+    } else if (mPushMode) {
+        ret = WaitForSignalOrExitLocked();
     } else {
-        ret = WaitForSignalOrExitLocked(kQueryPeriodNanosecs);
+        ret = WaitForSignalOrExitLocked(mRoiTracker ? mRoiTracker->getPeriodNs()
+                                                    : kQueryPeriodNanosecs);
     }
     if (ret == -EINTR) {
         OP_MANAGER_LOGE(mOpRateManager->mDisplay, "histogram failed to wait for signal");
@@ -488,33 +1056,52 @@ void ExynosPrimaryDisplayModule::OperationRateManager::HistogramQueryWorker::Rou
     }
     Unlock();
 
+    HistogramRoiTracker::Query_t query = {{}, 1.0f};
+    if (mRoiTracker) {
+        // nothing was drawn since the last queries, the histogram is unchanged
+        if (!mRoiTracker->getNextQuery(&query)) return;
+        // a partial roi is tracked relative to a full screen baseline
+        if (!mPrevHistogramLuma) query = {{}, 1.0f};
+    }
+    bool roiChanged = query.roi != mRoi;
+    if (roiChanged && !reconfigRoi(query.roi)) return;
+
     HistogramDevice::HistogramErrorCode err = HistogramDevice::HistogramErrorCode::NONE;
-    std::vector<char16_t> data;
+    // the worker runs at urgent display priority, offer the capacity of the previous query
+    std::vector<char16_t>* bins = mHistogramBuffer.prepare();
     ndk::ScopedAStatus status =
-            mOpRateManager->mDisplay->mHistogramController->queryHistogram(mSpAIBinder, &data,
+            mOpRateManager->mDisplay->mHistogramController->queryHistogram(mSpAIBinder, bins,
                                                                            &err);
     if (status.isOk() && err != HistogramDevice::HistogramErrorCode::BAD_TOKEN) {
-        if (!data.size()) {
+        if (mHistogramBuffer.empty()) {
             OP_MANAGER_LOGW(mOpRateManager->mDisplay, "histogram data is empty");
             return;
         }
-
-        float lumaSum = 0;
-        int count = 0;
-        for (int i = 0; i < data.size(); i++) {
-            lumaSum += i * static_cast<int>(data[i]);
-            count += static_cast<int>(data[i]);
+        if (mHistogramBuffer.updateCapacity()) {
+            OP_MANAGER_LOGW(mOpRateManager->mDisplay, "histogram buffer grown to %zu bins",
+                            mHistogramBuffer.getCapacity());
         }
-        if (!count) {
+
+        if (!mHistogramBuffer.computeStats(&mHistogramStats)) {
             OP_MANAGER_LOGW(mOpRateManager->mDisplay, "histogram count is 0");
             return;
         }
 
-        float luma = lumaSum / count;
+        float roiLuma = mHistogramStats.mean;
+        float luma = roiLuma;
+        if (!mRoi.isEmpty()) {
+            // the screen outside of the roi did not change, so its luma changes by the roi
+            // change scaled by the area; a new roi only takes its baseline
+            luma = roiChanged ? mPrevHistogramLuma
+                              : mPrevHistogramLuma + (roiLuma - mPrevRoiLuma) * query.areaRatio;
+        }
+        mPrevRoiLuma = roiLuma;
         float lumaDelta = abs(luma - mPrevHistogramLuma);
         DISPLAY_STR_LOGD(DISP_STR(mOpRateManager->mDisplay), eDebugOperationRate,
-                         "histogram luma %f, delta %f, th %f", luma, lumaDelta,
-                         mHistogramLumaDeltaThreshold);
+                         "histogram luma %f (var %f, p10/50/90 %u/%u/%u), delta %f, th %f", luma,
+                         mHistogramStats.variance, mHistogramStats.percentiles[0],
+                         mHistogramStats.percentiles[1], mHistogramStats.percentiles[2],
+                         lumaDelta, mHistogramLumaDeltaThreshold);
         if (mPrevHistogramLuma && lumaDelta > mHistogramLumaDeltaThreshold) {
             mQueryMode = false;
             mOpRateManager->onHistogram();
@@ -525,3 +1112,17 @@ void ExynosPrimaryDisplayModule::OperationRateManager::HistogramQueryWorker::Rou
         OP_MANAGER_LOGE(mOpRateManager->mDisplay, "histogram failed to query");
     }
 }
+
+void ExynosPrimaryDisplayModule::OperationRateManager::HistogramQueryWorker::dump(
+        String8& result) const {
+    result.appendFormat("\thistogram buffer: queries %" PRIu64 ", reallocated %" PRIu64 "\n",
+                        mHistogramBuffer.getQueryCnt(), mHistogramBuffer.getReallocCnt());
+    if (!mRoiTracker) return;
+
+    HistogramRoiTracker::Stats_t stats = mRoiTracker->getStats();
+    result.appendFormat("\thistogram frames %" PRIu64 " (damaged %" PRIu64 "), queries %" PRIu64
+                        " (skipped %" PRIu64 "), roi changes %" PRIu64 ", avg roi %.1f%%\n",
+                        stats.frameCnt, stats.damagedFrameCnt, stats.queryCnt, stats.skippedCnt,
+                        stats.roiChangeCnt,
+                        stats.queryCnt ? stats.roiAreaRatioSum * 100 / stats.queryCnt : 100.0);
+}
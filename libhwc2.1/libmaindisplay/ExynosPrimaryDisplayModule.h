@@ -17,8 +17,21 @@
 #ifndef EXYNOS_DISPLAY_MODULE_ZUMAPRO_H
 #define EXYNOS_DISPLAY_MODULE_ZUMAPRO_H
 
+#include <atomic>
+#include <unordered_map>
+
 #include "../../zuma/libhwc2.1/libmaindisplay/ExynosPrimaryDisplayModule.h"
+#include "ExynosResourceManagerModule.h"
 #include "HistogramController.h"
+#include "DisplayColorPreloader.h"
+#include "DisplaySettingsStore.h"
+#include "HistogramQueryBuffer.h"
+#include "HistogramRoiTracker.h"
+#include "HistogramStats.h"
+#include "LayerStackFingerprint.h"
+#include "OperationRateController.h"
+#include "OperationRateTelemetry.h"
+#include "SeqLockSnapshot.h"
 #include "worker.h"
 
 namespace zumapro {
@@ -31,12 +44,27 @@ public:
                                const std::string& displayName);
     ~ExynosPrimaryDisplayModule();
     int32_t validateWinConfigData() override;
+    int32_t presentDisplay(int32_t* outRetireFence) override;
     void checkPreblendingRequirement() override;
+    void dump(String8& result) override;
+    int32_t setPowerMode(int32_t mode) override;
+    int32_t setColorModeWithRenderIntent(int32_t mode, int32_t intent) override;
+    int32_t setColorTransform(const float* matrix, int32_t hint) override;
+    int32_t setDisplayBrightness(float brightness, bool waitPresent = false) override;
+    int32_t destroyLayer(hwc2_layer_t outLayer) override;
+
+    void invalidateLayerStackCache();
+    /*
+     * DPP features of the frame being validated, the client target at index 0 and mLayers[i]
+     * at index i + 1. Empty if they are not resolved, see lookupDppFeatureMasks().
+     */
+    const std::vector<uint8_t>& getDppFeatureMasks() const;
 
 protected:
     class OperationRateManager : public gs201::ExynosPrimaryDisplayModule::OperationRateManager {
     public:
-        OperationRateManager(ExynosPrimaryDisplay* display, int32_t hsHz, int32_t nsHz);
+        OperationRateManager(ExynosPrimaryDisplay* display, int32_t hsHz, int32_t nsHz,
+                             std::vector<int32_t> rates);
         virtual ~OperationRateManager();
 
         int32_t onLowPowerMode(bool enabled) override;
@@ -45,17 +73,45 @@ protected:
         int32_t onBrightness(uint32_t dbv) override;
         int32_t onPowerMode(int32_t mode) override;
         int32_t getTargetOperationRate() const override;
+        bool needsFrameDamage() const;
+        // called once per frame from the present path, `damage` is the bounding box of the
+        // changed regions and only computed if needsFrameDamage()
+        void onFrameUpdate(const HistogramRoiTracker::Rect_t& damage);
+        // called after the frame is committed to the display
+        void onFramePresented();
+        void dump(String8& result) const;
+        // residency, switch reasons and latencies since boot
+        void getStats(OperationRateStats_t* stats) const;
+
+        struct State_t {
+            int32_t dbv;
+            int32_t refreshRate;
+            int32_t peakRefreshRate;
+            int32_t powerMode; // kPowerModeUnknown if not set
+            int32_t targetOperationRate;
+            bool lowBatteryMode;
+        };
+        // inputs and decision as of the last hook, readable from any thread without blocking
+        State_t getState(uint32_t* version = nullptr) const;
+        static constexpr int32_t kPowerModeUnknown = -1;
 
     protected:
         class HistogramQueryWorker : public Worker {
         public:
-            HistogramQueryWorker(OperationRateManager* op, float deltaThreshold);
+            HistogramQueryWorker(OperationRateManager* op, float deltaThreshold, bool pushMode,
+                                 bool adaptiveRoi);
             ~HistogramQueryWorker();
 
             bool isRuntimeResolutionConfig() const;
             void updateConfig(uint32_t xres, uint32_t yres);
             void startQuery();
             void stopQuery();
+            bool isAdaptiveRoi() const { return mRoiTracker != nullptr; }
+            // `damage` is only used in adaptive roi mode
+            void onFrameUpdate(const HistogramRoiTracker::Rect_t& damage);
+            // push mode queries the histogram of each committed frame
+            void onFramePresented();
+            void dump(String8& result) const;
 
         protected:
             void Routine() override;
@@ -63,14 +119,30 @@ protected:
         private:
             void prepare();
             void unprepare();
+            bool reconfigRoi(const HistogramRoiTracker::Rect_t& roi);
 
             OperationRateManager* mOpRateManager;
+            // query on frame updates instead of every kQueryPeriodNanosecs
+            const bool mPushMode;
             ndk::SpAIBinder mSpAIBinder;
             HistogramDevice::HistogramConfig mConfig;
-            bool mReady;
-            bool mQueryMode;
+            // also read by the frame hooks outside of Lock()
+            std::atomic<bool> mReady;
+            std::atomic<bool> mQueryMode;
             float mHistogramLumaDeltaThreshold;
             float mPrevHistogramLuma;
+            // statistics of the last queried histogram
+            HistogramStats_t mHistogramStats;
+            // preallocated query buffer, reused if queryHistogram() refills it in place
+            HistogramQueryBuffer mHistogramBuffer;
+            // skips queries of unchanged content and limits the roi to the damage, optional
+            std::unique_ptr<HistogramRoiTracker> mRoiTracker;
+            // roi registered with the controller, empty for full screen
+            HistogramRoiTracker::Rect_t mRoi;
+            float mPrevRoiLuma;
+            // the roi is in the coordinates of the resolution at registration
+            uint32_t mRegisteredXres;
+            uint32_t mRegisteredYres;
 
             // Use the fixed weights from sensor team's measurement (b/286330225). These values
             // can be used for all devices since we just need a fix set then the DTE team can
@@ -78,39 +150,147 @@ protected:
             static constexpr uint32_t kHistogramConfigWeightR = 186;
             static constexpr uint32_t kHistogramConfigWeightG = 766;
             static constexpr uint32_t kHistogramConfigWeightB = 72;
+
+            static constexpr uint32_t kRoiStableFrames = 30;
+            static constexpr uint32_t kRoiMaxAreaPercent = 50;
+            static constexpr int64_t kQueryMaxPeriodNanosecs =
+                    std::chrono::nanoseconds(std::chrono::milliseconds(800)).count();
         };
 
-    private:
-        enum class DispOpCondition : uint32_t {
-            PANEL_SET_POWER = 0,
-            SET_CONFIG,
-            SET_DBV,
-            HISTOGRAM_DELTA,
-            MAX,
+        // applies a switch held by the dwell time at its deadline, also on a static screen
+        class DwellTimerWorker : public Worker {
+        public:
+            explicit DwellTimerWorker(OperationRateManager* op);
+            ~DwellTimerWorker();
+
+            // wake up for a new deadline
+            void arm();
+
+        protected:
+            void Routine() override;
+
+        private:
+            OperationRateManager* mOpRateManager;
         };
 
+    private:
+        using DispOpCondition = OperationRatePolicy::Condition;
+
         int32_t onHistogram();
+        // return true if a held switch was due and re-evaluated, `wait` blocks on mLock
+        bool applyExpiredDwell(bool wait);
         int32_t updateOperationRateLocked(const DispOpCondition cond);
+        void publishStateLocked();
 
         ExynosPrimaryDisplay* mDisplay;
         const int32_t mDisplayHsOperationRate;
         const int32_t mDisplayNsOperationRate;
-        int32_t mDisplayTargetOperationRate;
         int32_t mDisplayNsMinDbv;
-        int32_t mDisplayPeakRefreshRate;
-        int32_t mDisplayRefreshRate;
-        int32_t mDisplayLastDbv;
-        int32_t mDisplayDbv;
         int32_t mDisplayHsSwitchMinDbv;
         std::optional<hwc2_power_mode_t> mDisplayPowerMode;
-        bool mDisplayLowBatteryModeEnabled;
-        Mutex mLock;
+        // serializes the hooks, getTargetOperationRate() reads mState instead
+        mutable Mutex mLock;
+        SeqLockSnapshot<State_t> mState;
 
         static constexpr uint32_t kBrightnessDeltaThreshold = 10;
         static constexpr uint32_t kLowPowerOperationRate = 30;
+        // brightness updates further apart than this are not the same ramp
+        static constexpr int64_t kDbvRampMaxStepNs = std::chrono::nanoseconds(
+                std::chrono::milliseconds(200)).count();
 
         std::unique_ptr<HistogramQueryWorker> mHistogramQueryWorker;
+        // inputs and decisions, shared with the host simulator
+        std::unique_ptr<OperationRateController> mController;
+        // only created with a dwell time, stopped before mController goes away
+        std::unique_ptr<DwellTimerWorker> mDwellTimer;
+        std::unique_ptr<OperationRateTelemetry> mTelemetry;
+        // no property I/O under mLock, reads and writes go through the store
+        std::unique_ptr<DisplaySettingsStore> mSettings;
+        // condition of the last update, attributed to the next rate change
+        DispOpCondition mLastCondition = DispOpCondition::PANEL_SET_POWER;
+    };
+
+private:
+    // ascending unique list from a comma separated property, empty if unset or invalid
+    static std::vector<int32_t> parseOperationRates(const char* prop);
+
+    /*
+     * Decisions of the last layer stack. Most frames only change the buffers, so the same
+     * LayerStackFingerprint, which includes the color generation, gives the same decisions.
+     */
+    struct LayerStackCache {
+        bool valid = false;
+        uint64_t fingerprint = 0;
+        std::vector<bool> layerNeedPreblending;
+        bool clientNeedPreblending = false;
+
+        uint64_t hitCnt = 0;
+        uint64_t missCnt = 0;
+        uint64_t invalidateCnt = 0;
+        // average cost of a miss, used to estimate the time saved by the hits
+        int64_t avgMissNs = 0;
+    };
+
+    /*
+     * Preblending decision per layer, for the frames that miss the layer stack cache. The DPP
+     * state of a layer follows its dataspace, its color transform, HDR metadata and dimming,
+     * and the color settings and brightness of the display. A change of the display settings
+     * bumps the generation. Layers are identified by an id instead of their address, which a
+     * new layer can reuse after destroyLayer().
+     */
+    struct PreblendingCache {
+        struct Key {
+            uint64_t layerId;
+            uint64_t generation;
+            bool operator==(const Key& key) const {
+                return layerId == key.layerId && generation == key.generation;
+            }
+        };
+        struct KeyHash {
+            size_t operator()(const Key& key) const {
+                return std::hash<uint64_t>()(key.layerId * 0x9e3779b97f4a7c15ULL ^
+                                             key.generation);
+            }
+        };
+        struct Entry {
+            int32_t dataspace = 0;
+            // hash of the other per layer inputs, see updatePreblendingRequirement()
+            uint64_t colorState = 0;
+            uint8_t featureMask = 0;
+            // frame of the last use, entries of removed layers and old generations are dropped
+            uint64_t frame = 0;
+        };
+        std::unordered_map<Key, Entry, KeyHash> entries;
+        // ids of the layers of the display, the client target always uses kClientTargetId
+        std::unordered_map<const ExynosMPPSource*, uint64_t> layerIds;
+        static constexpr uint64_t kClientTargetId = 0;
+        uint64_t nextLayerId = kClientTargetId + 1;
+        uint64_t generation = 1;
+        uint64_t frame = 0;
+        // DPP features of the last resolved layer stack, see getDppFeatureMasks()
+        std::vector<uint8_t> featureMasks;
+        // scratch of the color state of each entry of featureMasks
+        std::vector<uint64_t> colorStates;
+
+        uint64_t lookupCnt = 0;
+        uint64_t skipCnt = 0;
     };
+
+    uint64_t computeLayerStackFingerprint();
+    // logs the result of the color library preload and drops the preloader once done
+    void finishDisplayColorPreload();
+    void updatePreblendingRequirement();
+    // bounding box of the surface damage of the frame, in display coordinates
+    HistogramRoiTracker::Rect_t computeFrameDamage();
+    void dumpLayerStackCache(String8& result) const;
+
+    LayerStackCache mLayerStackCache;
+    PreblendingCache mPreblendingCache;
+    // set with vendor.primarydisplay.displaycolor_preload until a frame after the load
+    std::unique_ptr<DisplayColorPreloader> mDisplayColorPreloader;
+    std::optional<uint64_t> mLayerStackFingerprint;
+    // layer stack of the previous computeFrameDamage(), any change damages the whole screen
+    std::optional<uint64_t> mDamageFingerprint;
 };
 
 } // namespace zumapro
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _HISTOGRAM_QUERY_BUFFER_ZUMAPRO_H
+#define _HISTOGRAM_QUERY_BUFFER_ZUMAPRO_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "HistogramStats.h"
+
+namespace zumapro {
+
+/*
+ * Caller owned bins of the histogram queries, reserved for kHistogramStatsMaxBins up front.
+ * The storage is only reused if HistogramController::queryHistogram() refills the vector it
+ * is given in place rather than replacing it. The buffer counts the queries that came back
+ * in other storage, so dumpsys shows whether the real controller does.
+ */
+class HistogramQueryBuffer {
+public:
+    HistogramQueryBuffer() : mCapacity(kHistogramStatsMaxBins) { mBins.reserve(mCapacity); }
+
+    /* the emptied vector to pass to queryHistogram() */
+    std::vector<char16_t>* prepare() {
+        mBins.clear();
+        mData = mBins.data();
+        return &mBins;
+    }
+
+    /*
+     * account the last query, return true if it needed more bins than reserved so far.
+     * A replaced vector the allocator happens to place at the old address is not counted.
+     */
+    bool updateCapacity() {
+        mQueryCnt.fetch_add(1, std::memory_order_relaxed);
+        if (mBins.data() != mData) mReallocCnt.fetch_add(1, std::memory_order_relaxed);
+        if (mBins.size() <= mCapacity) return false;
+        mCapacity = mBins.size();
+        return true;
+    }
+
+    bool computeStats(HistogramStats_t* stats) const {
+        return computeHistogramStats(mBins.data(), mBins.size(), stats);
+    }
+
+    bool empty() const { return mBins.empty(); }
+    size_t getCapacity() const { return mCapacity; }
+    uint64_t getQueryCnt() const { return mQueryCnt.load(std::memory_order_relaxed); }
+    /* queries the controller returned in storage other than the reserved one */
+    uint64_t getReallocCnt() const { return mReallocCnt.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<char16_t> mBins;
+    size_t mCapacity;
+    const char16_t* mData = nullptr;
+    // read by dumpsys
+    std::atomic<uint64_t> mQueryCnt{0};
+    std::atomic<uint64_t> mReallocCnt{0};
+};
+
+} // namespace zumapro
+
+#endif // _HISTOGRAM_QUERY_BUFFER_ZUMAPRO_H
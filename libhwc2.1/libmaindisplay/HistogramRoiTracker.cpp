@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HistogramRoiTracker.h"
+
+#include <algorithm>
+
+using namespace zumapro;
+
+// the histogram may still show the frame before the damage at the first query after it
+static constexpr uint32_t kQueriesPerDamage = 2;
+
+bool HistogramRoiTracker::Rect_t::contains(const Rect_t& rect) const {
+    return left <= rect.left && top <= rect.top && right >= rect.right && bottom >= rect.bottom;
+}
+
+void HistogramRoiTracker::Rect_t::unite(const Rect_t& rect) {
+    if (rect.isEmpty()) return;
+    if (isEmpty()) {
+        *this = rect;
+        return;
+    }
+    left = std::min(left, rect.left);
+    top = std::min(top, rect.top);
+    right = std::max(right, rect.right);
+    bottom = std::max(bottom, rect.bottom);
+}
+
+HistogramRoiTracker::HistogramRoiTracker(Config_t config)
+      : mConfig(config),
+        mRoiEnabled(config.stableFrames > 0),
+        mWidth(0),
+        mHeight(0),
+        mRoi{},
+        mWindow{},
+        mWindowFrames(0),
+        mPendingQueries(kQueriesPerDamage),
+        mPeriodNs(config.basePeriodNs),
+        mStats{} {}
+
+void HistogramRoiTracker::setRoiLocked(const Rect_t& roi) {
+    if (roi != mRoi) mStats.roiChangeCnt++;
+    mRoi = roi;
+    mWindow = {};
+    mWindowFrames = 0;
+}
+
+bool HistogramRoiTracker::onFrame(const Rect_t& damage, int32_t width, int32_t height) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.frameCnt++;
+    if (width != mWidth || height != mHeight) {
+        mWidth = width;
+        mHeight = height;
+        setRoiLocked({});
+    }
+    if (damage.isEmpty()) return false;
+
+    mStats.damagedFrameCnt++;
+    mPendingQueries = kQueriesPerDamage;
+    bool wake = mPeriodNs > mConfig.basePeriodNs;
+    mPeriodNs = mConfig.basePeriodNs;
+    if (!mRoiEnabled) return wake;
+
+    if (!mRoi.isEmpty() && !mRoi.contains(damage)) {
+        // the query after this compares the full screen with the estimate of the roi
+        setRoiLocked({});
+    }
+    mWindow.unite(damage);
+    if (++mWindowFrames >= mConfig.stableFrames) {
+        int64_t screenArea = static_cast<int64_t>(mWidth) * mHeight;
+        if (mWindow.getArea() * 100 <= screenArea * mConfig.maxAreaPercent) {
+            setRoiLocked(mWindow);
+        } else {
+            mWindow = {};
+            mWindowFrames = 0;
+        }
+    }
+    return wake;
+}
+
+void HistogramRoiTracker::reset() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    setRoiLocked({});
+    mPendingQueries = kQueriesPerDamage;
+    mPeriodNs = mConfig.basePeriodNs;
+}
+
+bool HistogramRoiTracker::getNextQuery(Query_t* query) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mPendingQueries) {
+        mStats.skippedCnt++;
+        mPeriodNs = std::min(mPeriodNs * 2, mConfig.maxPeriodNs);
+        return false;
+    }
+    mPendingQueries--;
+    int64_t screenArea = static_cast<int64_t>(mWidth) * mHeight;
+    query->roi = mRoi;
+    query->areaRatio = mRoi.isEmpty() || !screenArea
+            ? 1.0f
+            : static_cast<float>(mRoi.getArea()) / static_cast<float>(screenArea);
+    mStats.queryCnt++;
+    mStats.roiAreaRatioSum += query->areaRatio;
+    return true;
+}
+
+void HistogramRoiTracker::disableRoi() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRoiEnabled = false;
+    setRoiLocked({});
+}
+
+int64_t HistogramRoiTracker::getPeriodNs() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPeriodNs;
+}
+
+HistogramRoiTracker::Stats_t HistogramRoiTracker::getStats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _HISTOGRAM_ROI_TRACKER_ZUMAPRO_H
+#define _HISTOGRAM_ROI_TRACKER_ZUMAPRO_H
+
+#include <cstdint>
+#include <mutex>
+
+namespace zumapro {
+
+/*
+ * Damage of the frames since the last histogram query, so the query worker can skip queries
+ * while nothing is drawn and limit the roi to the region that keeps changing (a video, an
+ * animation). The roi only shrinks after the damage stayed inside it for a number of frames
+ * and returns to full screen on the first damage outside of it. onFrame() is called from
+ * the display thread, the rest from the query worker.
+ */
+class HistogramRoiTracker {
+public:
+    struct Rect_t {
+        int32_t left;
+        int32_t top;
+        int32_t right;
+        int32_t bottom;
+
+        bool isEmpty() const { return right <= left || bottom <= top; }
+        int64_t getArea() const {
+            return isEmpty() ? 0 : static_cast<int64_t>(right - left) * (bottom - top);
+        }
+        bool contains(const Rect_t& rect) const;
+        void unite(const Rect_t& rect);
+        bool operator==(const Rect_t& rect) const {
+            return left == rect.left && top == rect.top && right == rect.right &&
+                    bottom == rect.bottom;
+        }
+        bool operator!=(const Rect_t& rect) const { return !(*this == rect); }
+    };
+
+    struct Config_t {
+        uint32_t stableFrames;   // damaged frames before shrinking the roi, 0 keeps full screen
+        uint32_t maxAreaPercent; // larger damage keeps the full screen roi
+        int64_t basePeriodNs;    // polling period while the content changes
+        int64_t maxPeriodNs;     // the period doubles up to this while nothing is drawn
+    };
+
+    struct Query_t {
+        Rect_t roi;      // empty for full screen
+        float areaRatio; // roi area over the screen area
+    };
+
+    struct Stats_t {
+        uint64_t frameCnt;
+        uint64_t damagedFrameCnt;
+        uint64_t queryCnt;
+        uint64_t skippedCnt;
+        uint64_t roiChangeCnt;
+        double roiAreaRatioSum; // over the queries, for the average roi size
+    };
+
+    explicit HistogramRoiTracker(Config_t config);
+
+    // `damage` in display coordinates, empty if the frame did not change the content.
+    // Returns true if the worker is backed off and should be woken up.
+    bool onFrame(const Rect_t& damage, int32_t width, int32_t height);
+    // back to full screen and an unconditional query, when a query run starts
+    void reset();
+    // false if the histogram cannot have changed since the previous queries
+    bool getNextQuery(Query_t* query);
+    // stop shrinking the roi, e.g. if the controller rejected it
+    void disableRoi();
+    int64_t getPeriodNs() const;
+    Stats_t getStats() const;
+
+private:
+    void setRoiLocked(const Rect_t& roi);
+
+    const Config_t mConfig;
+    mutable std::mutex mMutex;
+    bool mRoiEnabled;
+    int32_t mWidth;
+    int32_t mHeight;
+    Rect_t mRoi;
+    // union of the damage since the roi was last considered
+    Rect_t mWindow;
+    uint32_t mWindowFrames;
+    // queries left before the damage is surely in the histogram
+    uint32_t mPendingQueries;
+    int64_t mPeriodNs;
+    Stats_t mStats;
+};
+
+} // namespace zumapro
+
+#endif // _HISTOGRAM_ROI_TRACKER_ZUMAPRO_H
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HistogramStats.h"
+
+// tests/neon provides the intrinsics on hosts without NEON, see Android.bp
+#if defined(__aarch64__) || defined(HISTOGRAM_STATS_NEON_EMULATION)
+#define HISTOGRAM_STATS_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace zumapro;
+
+namespace {
+
+// bins per chunk, one 128-bit vector of 16-bit bins
+constexpr size_t kChunkBins = 8;
+constexpr size_t kMaxChunks = kHistogramStatsMaxBins / kChunkBins;
+
+typedef std::array<uint32_t, kMaxChunks> ChunkSums;
+
+bool finishStats(const char16_t* bins, size_t size, const ChunkSums& chunkSums, uint64_t count,
+                 uint64_t sum, uint64_t sumSq, HistogramStats_t* stats) {
+    if (!count) return false;
+
+    double mean = static_cast<double>(sum) / count;
+    double variance = static_cast<double>(sumSq) / count - mean * mean;
+    stats->count = count;
+    stats->mean = static_cast<float>(mean);
+    stats->variance = static_cast<float>(variance > 0 ? variance : 0);
+
+    // first bin where the cumulative count reaches the percentile
+    size_t chunk = 0;
+    uint64_t cumulative = 0;
+    for (size_t p = 0; p < kHistogramPercentiles.size(); p++) {
+        uint64_t target = count * kHistogramPercentiles[p];
+        while ((cumulative + chunkSums[chunk]) * 100 < target) {
+            cumulative += chunkSums[chunk++];
+        }
+        size_t bin = chunk * kChunkBins;
+        uint64_t binCumulative = cumulative + bins[bin];
+        while (binCumulative * 100 < target && bin + 1 < size) {
+            binCumulative += bins[++bin];
+        }
+        stats->percentiles[p] = bin;
+    }
+    return true;
+}
+
+} // namespace
+
+bool zumapro::computeHistogramStatsScalar(const char16_t* bins, size_t size,
+                                          HistogramStats_t* stats) {
+    if (!size || size > kHistogramStatsMaxBins) return false;
+
+    ChunkSums chunkSums{};
+    uint64_t count = 0, sum = 0, sumSq = 0;
+    for (size_t i = 0; i < size; i++) {
+        uint64_t value = bins[i];
+        chunkSums[i / kChunkBins] += value;
+        count += value;
+        sum += i * value;
+        sumSq += i * i * value;
+    }
+    return finishStats(bins, size, chunkSums, count, sum, sumSq, stats);
+}
+
+#if defined(HISTOGRAM_STATS_NEON)
+bool zumapro::computeHistogramStats(const char16_t* bins, size_t size, HistogramStats_t* stats) {
+    if (!size || size > kHistogramStatsMaxBins) return false;
+    if (size % kChunkBins) return computeHistogramStatsScalar(bins, size, stats);
+
+    static const uint16_t kLaneIndex[kChunkBins] = {0, 1, 2, 3, 4, 5, 6, 7};
+    const uint16_t* data = reinterpret_cast<const uint16_t*>(bins);
+    uint16x8_t index = vld1q_u16(kLaneIndex);
+    const uint16x8_t step = vdupq_n_u16(kChunkBins);
+
+    ChunkSums chunkSums;
+    uint64x2_t sumAcc = vdupq_n_u64(0);
+    uint64x2_t sumSqAcc = vdupq_n_u64(0);
+    uint64_t count = 0;
+    for (size_t chunk = 0; chunk < size / kChunkBins; chunk++) {
+        uint16x8_t value = vld1q_u16(data + chunk * kChunkBins);
+        chunkSums[chunk] = vaddlvq_u16(value);
+        count += chunkSums[chunk];
+
+        // index * value fits in 32 bits, index^2 * value needs 64 bits
+        uint32x4_t weightedLo = vmull_u16(vget_low_u16(index), vget_low_u16(value));
+        uint32x4_t weightedHi = vmull_high_u16(index, value);
+        sumAcc = vpadalq_u32(sumAcc, weightedLo);
+        sumAcc = vpadalq_u32(sumAcc, weightedHi);
+
+        uint32x4_t indexLo = vmovl_u16(vget_low_u16(index));
+        uint32x4_t indexHi = vmovl_high_u16(index);
+        sumSqAcc = vmlal_u32(sumSqAcc, vget_low_u32(weightedLo), vget_low_u32(indexLo));
+        sumSqAcc = vmlal_high_u32(sumSqAcc, weightedLo, indexLo);
+        sumSqAcc = vmlal_u32(sumSqAcc, vget_low_u32(weightedHi), vget_low_u32(indexHi));
+        sumSqAcc = vmlal_high_u32(sumSqAcc, weightedHi, indexHi);
+
+        index = vaddq_u16(index, step);
+    }
+    return finishStats(bins, size, chunkSums, count, vaddvq_u64(sumAcc), vaddvq_u64(sumSqAcc),
+                       stats);
+}
+#else
+bool zumapro::computeHistogramStats(const char16_t* bins, size_t size, HistogramStats_t* stats) {
+    return computeHistogramStatsScalar(bins, size, stats);
+}
+#endif
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _HISTOGRAM_STATS_ZUMAPRO_H
+#define _HISTOGRAM_STATS_ZUMAPRO_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace zumapro {
+
+/* percentiles reported in HistogramStats_t::percentiles, in percent */
+constexpr std::array<uint32_t, 3> kHistogramPercentiles = {10, 50, 90};
+
+struct HistogramStats_t {
+    uint64_t count;
+    float mean;
+    float variance;
+    // bin index of each of kHistogramPercentiles
+    std::array<uint32_t, kHistogramPercentiles.size()> percentiles;
+};
+
+// larger histograms are rejected by computeHistogramStats()
+constexpr size_t kHistogramStatsMaxBins = 1024;
+
+/*
+ * Luma statistics of a histogram in a single pass over the bins, vectorized with NEON on
+ * arm64. Percentiles are located from per-chunk bin sums gathered in the same pass, so only
+ * one chunk is scanned again per percentile. Returns false if there are no bins, too many
+ * bins (more than kHistogramStatsMaxBins) or the histogram is empty.
+ */
+bool computeHistogramStats(const char16_t* bins, size_t size, HistogramStats_t* stats);
+/* the same statistics without NEON, used when size isn't a multiple of the vector width */
+bool computeHistogramStatsScalar(const char16_t* bins, size_t size, HistogramStats_t* stats);
+
+} // namespace zumapro
+
+#endif // _HISTOGRAM_STATS_ZUMAPRO_H
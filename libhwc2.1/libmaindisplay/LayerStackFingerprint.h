@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LAYER_STACK_FINGERPRINT_ZUMAPRO_H
+#define _LAYER_STACK_FINGERPRINT_ZUMAPRO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace zumapro {
+
+/* Properties of a layer the layer stack decisions depend on, all but the buffer handle */
+struct LayerStackKey_t {
+    float sourceCrop[4];
+    int32_t displayFrame[4];
+    uint32_t transform;
+    int32_t dataspace;
+    uint32_t format;
+    uint32_t compression;
+    bool hdr;
+    float brightness;
+    // hashBytes() of the matrix of the layer color transform, 0 if it is disabled
+    uint64_t colorTransform;
+    // hashBytes() of the HDR static and dynamic metadata the layer carries, 0 if none
+    uint64_t hdrMetadata;
+};
+
+/*
+ * Hash of the layer stack of a frame. It takes the fields of the layers as they are, so a
+ * frame costs no image setup, and it covers the display config and the color generation
+ * as well, so a change of the color settings never hits an older stack.
+ */
+class LayerStackFingerprint {
+public:
+    LayerStackFingerprint(uint64_t layerCnt, uint32_t config, uint32_t xres, uint32_t yres,
+                          uint64_t colorGeneration)
+          : mHash(0) {
+        combine(layerCnt);
+        combine(config);
+        combine((static_cast<uint64_t>(xres) << 32) | yres);
+        combine(colorGeneration);
+    }
+
+    void addLayer(const LayerStackKey_t& key) {
+        for (float value : key.sourceCrop) combine(getBits(value));
+        for (int32_t value : key.displayFrame) combine(static_cast<uint32_t>(value));
+        combine(key.transform);
+        combine(static_cast<uint32_t>(key.dataspace));
+        combine(key.format);
+        combine(key.compression);
+        combine(key.hdr);
+        combine(getBits(key.brightness));
+        combine(key.colorTransform);
+        combine(key.hdrMetadata);
+    }
+
+    uint64_t get() const { return mHash; }
+
+    /* FNV-1a of the bytes for the fields too large to go in the key, never 0 */
+    static uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0) {
+        uint64_t hash = 0xcbf29ce484222325ULL ^ seed;
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+        return hash ? hash : 1;
+    }
+
+private:
+    static uint32_t getBits(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+    void combine(uint64_t value) {
+        mHash ^= value + 0x9e3779b97f4a7c15ULL + (mHash << 6) + (mHash >> 2);
+    }
+
+    uint64_t mHash;
+};
+
+} // namespace zumapro
+
+#endif // _LAYER_STACK_FINGERPRINT_ZUMAPRO_H
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OperationRateController.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace zumapro;
+
+OperationRateController::OperationRateController(Config_t config)
+      : mHasHistogram(config.hasHistogram),
+        mPolicy(std::move(config.policy)),
+        mDwellFilter(config.dwell, mPolicy.getHighestRate()),
+        mDbvPredictor(config.dbvPredictor),
+        // the panel is on when the manager is created
+        mPower(PowerState::ON),
+        mRefreshRate(0),
+        mPeakRefreshRate(0),
+        mDbv(0),
+        mLastDbv(0),
+        mTargetRate(mPolicy.getHighestRate()),
+        mLowBatteryMode(false),
+        mDwellPending(false),
+        mDwellDeadlineNs(0) {}
+
+bool OperationRateController::setDbv(int32_t dbv, int64_t nowNs) {
+    if (dbv == 0 || dbv == mLastDbv) return false;
+    mDbv = dbv;
+    const auto& config = mPolicy.getConfig();
+    mDbvPredictor.onDbv(dbv, mLowBatteryMode ? config.nsMinDbv : config.hsSwitchMinDbv, nowNs);
+    return true;
+}
+
+OperationRateController::Update_t OperationRateController::update(Condition cond,
+                                                                  bool configSettingEnabled,
+                                                                  int64_t nowNs) {
+    OperationRatePolicy::Input_t input = {};
+    input.cond = cond;
+    input.power = mPower;
+    input.refreshRate = mRefreshRate;
+    input.peakRefreshRate = mPeakRefreshRate;
+    input.dbv = (cond == Condition::SET_DBV) ? mDbv : mLastDbv;
+    input.predictedDbv = (cond == Condition::SET_DBV && mDbvPredictor.isEnabled())
+            ? mDbvPredictor.predict()
+            : input.dbv;
+    input.lastDbv = mLastDbv;
+    input.targetRate = mTargetRate;
+    input.lowBatteryMode = mLowBatteryMode;
+    input.hasHistogram = mHasHistogram;
+    input.configSettingEnabled = configSettingEnabled;
+
+    Update_t out = {};
+    out.decision = mPolicy.evaluate(input);
+    out.dbv = input.dbv;
+    out.dbvDelta = std::abs(input.dbv - mLastDbv);
+    auto& decision = out.decision;
+
+    // a held switch stays pending until it is re-evaluated, other hooks may not switch
+    bool dwellExpired = (cond == Condition::DWELL_EXPIRED);
+    if (dwellExpired) mDwellPending = false;
+    int32_t heldRate = decision.targetRate;
+    if (int64_t remainingNs = mDwellFilter.hold(input, &decision, nowNs)) {
+        out.heldRate = heldRate;
+        out.heldNs = remainingNs;
+        mDwellDeadlineNs = nowNs + remainingNs;
+        mDwellPending = true;
+        mStats.dwellHeldCnt++;
+    } else if (dwellExpired && decision.targetChanged) {
+        mStats.dwellAppliedCnt++;
+    }
+    if (decision.hysteresisHeld) mStats.hysteresisHeldCnt++;
+    if (decision.outcome != OperationRatePolicy::Outcome::APPLIED) decision.startQuery = false;
+    if (decision.outcome == OperationRatePolicy::Outcome::POWER_OFF) return out;
+
+    if (mTargetRate != decision.targetRate) {
+        mTargetRate = decision.targetRate;
+        mDwellFilter.onRateChanged(mTargetRate, nowNs);
+    }
+    if (decision.updateLastDbv) mLastDbv = input.dbv;
+    return out;
+}
+
+int64_t OperationRateController::getDwellWaitNs(int64_t nowNs) const {
+    if (!isDwellPending()) return -1;
+    return std::max<int64_t>(getDwellDeadlineNs() - nowNs, 0);
+}
+
+int32_t OperationRateController::getOperationRate() const {
+    switch (mPower) {
+        case PowerState::LP:
+            return mPolicy.getConfig().lowPowerRate;
+        case PowerState::OFF:
+            return 0;
+        default:
+            return mTargetRate;
+    }
+}
+
+OperationRateController::Stats_t OperationRateController::getStats() const {
+    Stats_t stats = {};
+    stats.dwellHeldCnt = mStats.dwellHeldCnt;
+    stats.dwellAppliedCnt = mStats.dwellAppliedCnt;
+    stats.hysteresisHeldCnt = mStats.hysteresisHeldCnt;
+    return stats;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPERATION_RATE_CONTROLLER_ZUMAPRO_H
+#define _OPERATION_RATE_CONTROLLER_ZUMAPRO_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "DbvTrendPredictor.h"
+#include "OperationRatePolicy.h"
+
+namespace zumapro {
+
+/*
+ * Inputs and transitions of OperationRateManager without the locking, properties, logs and
+ * the histogram query worker. The manager wraps it on the device and OperationRateSimulator
+ * replays traces through it on the host, so both run the same code from the same initial
+ * state. Not thread safe, except for isDwellPending(), getDwellDeadlineNs() and
+ * getDwellWaitNs().
+ */
+class OperationRateController {
+public:
+    using Condition = OperationRatePolicy::Condition;
+    using PowerState = OperationRatePolicy::PowerState;
+
+    struct Config_t {
+        OperationRatePolicy::Config_t policy;
+        OperationRateDwellFilter::Config_t dwell;
+        DbvTrendPredictor::Config_t dbvPredictor;
+        bool hasHistogram; // the histogram query worker runs
+    };
+
+    struct Update_t {
+        // the applied decision, startQuery is only set if the outcome is APPLIED
+        OperationRatePolicy::Decision_t decision;
+        int32_t dbv;      // dbv the decision was made for
+        int32_t dbvDelta; // change from the last dbv
+        int32_t heldRate; // switch held by the dwell time, 0 if none
+        int64_t heldNs;   // time left before the held switch is applied
+    };
+
+    struct Stats_t {
+        uint64_t dwellHeldCnt;
+        uint64_t dwellAppliedCnt;
+        uint64_t hysteresisHeldCnt;
+    };
+
+    explicit OperationRateController(Config_t config);
+
+    // inputs, evaluated by the next update()
+    void setPowerState(PowerState power) { mPower = power; }
+    void setRefreshRate(int32_t rate) { mRefreshRate = rate; }
+    void setPeakRefreshRate(int32_t rate) { mPeakRefreshRate = rate; }
+    void setLowBatteryMode(bool enabled) { mLowBatteryMode = enabled; }
+    // return false if the dbv is 0 or unchanged and needs no update
+    bool setDbv(int32_t dbv, int64_t nowNs);
+
+    Update_t update(Condition cond, bool configSettingEnabled, int64_t nowNs);
+
+    // a switch held by the dwell time waits for update(DWELL_EXPIRED) after the deadline
+    bool isDwellPending() const { return mDwellPending.load(std::memory_order_relaxed); }
+    int64_t getDwellDeadlineNs() const { return mDwellDeadlineNs.load(std::memory_order_relaxed); }
+    // time before the held switch is due, 0 once it is and -1 if none is pending
+    int64_t getDwellWaitNs(int64_t nowNs) const;
+
+    PowerState getPowerState() const { return mPower; }
+    int32_t getRefreshRate() const { return mRefreshRate; }
+    int32_t getPeakRefreshRate() const { return mPeakRefreshRate; }
+    int32_t getDbv() const { return mDbv; }
+    int32_t getLastDbv() const { return mLastDbv; }
+    int32_t getTargetRate() const { return mTargetRate; }
+    bool isLowBatteryMode() const { return mLowBatteryMode; }
+    // rate the panel runs at, the low power rate in LP and 0 while off
+    int32_t getOperationRate() const;
+
+    const OperationRatePolicy& getPolicy() const { return mPolicy; }
+    const DbvTrendPredictor& getDbvPredictor() const { return mDbvPredictor; }
+    Stats_t getStats() const;
+
+private:
+    const bool mHasHistogram;
+    const OperationRatePolicy mPolicy;
+    OperationRateDwellFilter mDwellFilter;
+    DbvTrendPredictor mDbvPredictor;
+
+    PowerState mPower;
+    int32_t mRefreshRate;
+    int32_t mPeakRefreshRate;
+    int32_t mDbv;
+    int32_t mLastDbv;
+    int32_t mTargetRate;
+    bool mLowBatteryMode;
+
+    std::atomic<bool> mDwellPending;
+    std::atomic<int64_t> mDwellDeadlineNs;
+
+    struct Stats {
+        std::atomic<uint64_t> dwellHeldCnt = 0;
+        std::atomic<uint64_t> dwellAppliedCnt = 0;
+        std::atomic<uint64_t> hysteresisHeldCnt = 0;
+    } mStats;
+};
+
+} // namespace zumapro
+
+#endif // _OPERATION_RATE_CONTROLLER_ZUMAPRO_H
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OperationRatePolicy.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+
+using namespace zumapro;
+
+namespace {
+
+using Condition = OperationRatePolicy::Condition;
+
+// predicates of the event rules
+enum : uint32_t {
+    kHistogram = 1u << 0,    // histogram query worker is running
+    kServable = 1u << 1,     // refresh rate is not above the highest rate
+    kBlocking = 1u << 2,     // dbv is in the blocking zone
+    kSameConfig = 1u << 3,   // refresh rate equals the current target rate
+    kHsDelayed = 1u << 4,    // low battery mode holds the switch to a higher rate
+    kAboveLowest = 1u << 5,  // refresh rate is above the lowest rate
+    kDesiredUp = 1u << 6,    // desired rate is the highest one or above the current one
+    kDbvDelta = 1u << 7,     // brightness changed more than the threshold
+    kLowestBlocked = 1u << 8 // lowest rate desired in the blocking zone
+};
+
+// actions of the event rules
+enum : uint32_t {
+    kNone = 0,
+    kApplyDesired = 1u << 0,     // switch to the desired rate
+    kApplyRefreshRate = 1u << 1, // switch up to the rate of the refresh rate
+    kDesireRefreshRate = 1u << 2,
+    kStopQuery = 1u << 3,
+    kReturnUnlessChange = 1u << 4,
+};
+
+struct Rule_t {
+    Condition cond;
+    uint32_t mask;
+    uint32_t value;
+    uint32_t actions;
+    const char* stopReason;
+};
+
+// first matching rule of the event wins
+constexpr Rule_t kRules[] = {
+        {Condition::SET_CONFIG, kServable, 0, kNone, nullptr},
+        {Condition::SET_CONFIG, kHistogram | kAboveLowest, kAboveLowest, kApplyRefreshRate,
+         nullptr},
+        {Condition::SET_CONFIG, kHistogram, 0, kNone, nullptr},
+        {Condition::SET_CONFIG, kBlocking, kBlocking, kNone, nullptr},
+        {Condition::SET_CONFIG, kHsDelayed | kSameConfig, kHsDelayed | kSameConfig,
+         kDesireRefreshRate | kStopQuery, "the same config"},
+        {Condition::SET_CONFIG, kHsDelayed, kHsDelayed, kDesireRefreshRate, nullptr},
+        {Condition::SET_CONFIG, kAboveLowest | kSameConfig, kAboveLowest | kSameConfig,
+         kApplyRefreshRate | kStopQuery, "the same config"},
+        {Condition::SET_CONFIG, kAboveLowest, kAboveLowest, kApplyRefreshRate, nullptr},
+        {Condition::SET_CONFIG, kSameConfig, kSameConfig, kStopQuery, "the same config"},
+        {Condition::SET_CONFIG, 0, 0, kNone, nullptr},
+
+        {Condition::PANEL_SET_POWER, 0, 0, kApplyDesired, nullptr},
+
+        {Condition::SET_DBV, kHistogram | kDesiredUp, kDesiredUp,
+         kApplyDesired | kReturnUnlessChange, nullptr},
+        {Condition::SET_DBV, kHistogram | kDbvDelta, kDbvDelta,
+         kApplyDesired | kReturnUnlessChange, nullptr},
+        {Condition::SET_DBV, kHistogram, 0, kReturnUnlessChange, nullptr},
+        {Condition::SET_DBV, kDbvDelta | kLowestBlocked, kDbvDelta | kLowestBlocked,
+         kApplyDesired | kStopQuery | kReturnUnlessChange, "dbv delta"},
+        {Condition::SET_DBV, kDbvDelta, kDbvDelta, kApplyDesired | kStopQuery, "dbv delta"},
+        {Condition::SET_DBV, kLowestBlocked, kLowestBlocked, kReturnUnlessChange, nullptr},
+        {Condition::SET_DBV, 0, 0, kNone, nullptr},
+
+        {Condition::HISTOGRAM_DELTA, 0, 0, kApplyDesired, nullptr},
+
+        {Condition::DWELL_EXPIRED, 0, 0, kApplyDesired, nullptr},
+};
+
+constexpr bool isRulesComplete() {
+    // every event ends with a catch-all rule
+    for (uint32_t cond = 0; cond < static_cast<uint32_t>(Condition::MAX); cond++) {
+        const Rule_t* last = nullptr;
+        for (const auto& rule : kRules) {
+            if (static_cast<uint32_t>(rule.cond) == cond) last = &rule;
+        }
+        if (!last || last->mask) return false;
+    }
+    return true;
+}
+static_assert(isRulesComplete(), "every condition needs a catch-all rule");
+
+const Rule_t& matchRule(Condition cond, uint32_t predicates) {
+    for (const auto& rule : kRules) {
+        if (rule.cond == cond && (predicates & rule.mask) == rule.value) return rule;
+    }
+    // unreachable, guaranteed by isRulesComplete()
+    return kRules[std::size(kRules) - 1];
+}
+
+} // namespace
+
+OperationRatePolicy::OperationRatePolicy(Config_t config) : mConfig(std::move(config)) {}
+
+int32_t OperationRatePolicy::getRateFor(int32_t rate) const {
+    auto it = std::lower_bound(mConfig.rates.begin(), mConfig.rates.end(), rate);
+    return it == mConfig.rates.end() ? getHighestRate() : *it;
+}
+
+OperationRatePolicy::Decision_t OperationRatePolicy::evaluate(const Input_t& in) const {
+    Decision_t out = {};
+    out.outcome = Outcome::APPLIED;
+    out.targetRate = in.targetRate;
+
+    // the lowest rate that keeps up with the refresh rate, capped by the peak refresh rate
+    int32_t floorRate = in.lowBatteryMode ? in.refreshRate
+            : in.peakRefreshRate          ? std::max(in.refreshRate, in.peakRefreshRate)
+                                          : getHighestRate();
+    out.desiredRate = getRateFor(floorRate);
+    int32_t blockingDbv = std::min(in.dbv, in.predictedDbv);
+    out.blocking = in.lowBatteryMode ? (blockingDbv < mConfig.nsMinDbv)
+                                     : (blockingDbv < mConfig.hsSwitchMinDbv);
+    if (out.blocking) out.desiredRate = getHighestRate();
+
+    int32_t effectiveRate = 0;
+    if (in.power == PowerState::LP) {
+        out.targetRate = mConfig.lowPowerRate;
+        out.desiredRate = mConfig.lowPowerRate;
+        effectiveRate = mConfig.lowPowerRate;
+    } else if (in.power == PowerState::OFF) {
+        out.outcome = Outcome::POWER_OFF;
+        out.stopQuery = in.hasHistogram;
+        out.stopReason = "power off";
+        return out;
+    }
+
+    uint32_t predicates = 0;
+    if (in.hasHistogram) predicates |= kHistogram;
+    if (in.refreshRate <= getHighestRate()) predicates |= kServable;
+    if (out.blocking) predicates |= kBlocking;
+    if (in.refreshRate == out.targetRate) predicates |= kSameConfig;
+    if (in.lowBatteryMode && (!mConfig.hsSwitchMinDbv || in.dbv < mConfig.hsSwitchMinDbv))
+        predicates |= kHsDelayed;
+    if (in.refreshRate > getLowestRate()) predicates |= kAboveLowest;
+    if (out.desiredRate == getHighestRate() ||
+        (out.desiredRate > out.targetRate && out.targetRate >= getLowestRate()))
+        predicates |= kDesiredUp;
+    int32_t dbvDelta = std::abs(in.dbv - in.lastDbv);
+    int32_t dbvDeltaThreshold = (out.desiredRate > out.targetRate)
+            ? mConfig.brightnessDeltaUpThreshold
+            : mConfig.brightnessDeltaDownThreshold;
+    if (dbvDelta > dbvDeltaThreshold) predicates |= kDbvDelta;
+    if (out.desiredRate == getLowestRate() && out.blocking) predicates |= kLowestBlocked;
+
+    const Rule_t& rule = matchRule(in.cond, predicates);
+    if (rule.actions & kDesireRefreshRate) out.desiredRate = in.refreshRate;
+    if (rule.actions & kApplyDesired) effectiveRate = out.desiredRate;
+    if ((rule.actions & kApplyRefreshRate) && getRateFor(in.refreshRate) > out.targetRate)
+        effectiveRate = getRateFor(in.refreshRate);
+    if (rule.actions & kStopQuery) {
+        out.stopQuery = true;
+        out.stopReason = rule.stopReason;
+    }
+    out.updateLastDbv = (in.cond == Condition::SET_DBV);
+
+    bool switching = effectiveRate > mConfig.lowPowerRate && effectiveRate != out.targetRate;
+    out.hysteresisHeld = in.cond == Condition::SET_DBV && !switching &&
+            out.desiredRate != out.targetRate && !(predicates & kDbvDelta) &&
+            dbvDelta > std::min(mConfig.brightnessDeltaUpThreshold,
+                                mConfig.brightnessDeltaDownThreshold);
+    if ((rule.actions & kReturnUnlessChange) && !switching) {
+        out.outcome = Outcome::NO_CHANGE;
+        return out;
+    }
+
+    bool isLowerRate = effectiveRate != getHighestRate() &&
+            std::binary_search(mConfig.rates.begin(), mConfig.rates.end(), effectiveRate);
+    if (!in.configSettingEnabled && isLowerRate) {
+        out.outcome = Outcome::SWITCH_DISABLED;
+        return out;
+    } else if (switching) {
+        out.targetRate = effectiveRate;
+        out.targetChanged = true;
+    }
+
+    out.startQuery = in.hasHistogram && out.targetRate != out.desiredRate;
+    return out;
+}
+
+OperationRateDwellFilter::OperationRateDwellFilter(Config_t config, int32_t highestRate)
+      : mConfig(config), mHighestRate(highestRate), mRate(highestRate), mSinceNs(0) {}
+
+int64_t OperationRateDwellFilter::hold(const OperationRatePolicy::Input_t& input,
+                                       OperationRatePolicy::Decision_t* decision,
+                                       int64_t nowNs) const {
+    if (!decision->targetChanged || !isEnabled() || decision->blocking ||
+        input.cond == Condition::PANEL_SET_POWER ||
+        input.power != OperationRatePolicy::PowerState::ON) {
+        return 0;
+    }
+    int64_t remainingNs = getRemainingNs(nowNs);
+    if (!remainingNs) return 0;
+
+    decision->targetRate = input.targetRate;
+    decision->targetChanged = false;
+    decision->stopQuery = false;
+    decision->stopReason = nullptr;
+    decision->startQuery = input.hasHistogram && decision->targetRate != decision->desiredRate;
+    return remainingNs;
+}
+
+int64_t OperationRateDwellFilter::getRemainingNs(int64_t nowNs) const {
+    int64_t minNs = (mRate == mHighestRate) ? mConfig.highestRateMinNs : mConfig.lowerRateMinNs;
+    return std::max<int64_t>(mSinceNs + minNs - nowNs, 0);
+}
+
+void OperationRateDwellFilter::onRateChanged(int32_t rate, int64_t nowNs) {
+    if (rate == mRate) return;
+    mRate = rate;
+    mSinceNs = nowNs;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPERATION_RATE_POLICY_ZUMAPRO_H
+#define _OPERATION_RATE_POLICY_ZUMAPRO_H
+
+#include <cstdint>
+#include <vector>
+
+namespace zumapro {
+
+/*
+ * Operation rate decision of OperationRateManager as a pure function of its inputs. The
+ * event specific part is a first match table of rules over a few predicates, the rest is
+ * shared by all events. Rates are an ascending list, the lowest one takes the place of NS
+ * and the highest one the place of HS.
+ */
+class OperationRatePolicy {
+public:
+    enum class Condition : uint32_t {
+        PANEL_SET_POWER = 0,
+        SET_CONFIG,
+        SET_DBV,
+        HISTOGRAM_DELTA,
+        DWELL_EXPIRED, // a switch held by OperationRateDwellFilter can be applied
+        MAX,
+    };
+
+    enum class PowerState : uint32_t {
+        ON = 0,
+        LP,
+        OFF, // also used before the first power mode
+    };
+
+    struct Config_t {
+        std::vector<int32_t> rates; // ascending
+        int32_t lowPowerRate;
+        int32_t nsMinDbv;
+        int32_t hsSwitchMinDbv;
+        // brightness change needed to switch to a higher or to a lower rate
+        int32_t brightnessDeltaUpThreshold;
+        int32_t brightnessDeltaDownThreshold;
+    };
+
+    struct Input_t {
+        Condition cond;
+        PowerState power;
+        int32_t refreshRate;
+        int32_t peakRefreshRate; // 0 if unknown
+        int32_t dbv;             // dbv of the event for SET_DBV, the last one otherwise
+        int32_t predictedDbv;    // dbv expected soon, the blocking zone is entered early
+        int32_t lastDbv;
+        int32_t targetRate;
+        bool lowBatteryMode;
+        bool hasHistogram;
+        bool configSettingEnabled;
+    };
+
+    enum class Outcome : uint32_t {
+        APPLIED = 0,
+        POWER_OFF,      // nothing to do until the panel is on
+        NO_CHANGE,      // brightness change too small to switch
+        SWITCH_DISABLED // lower rate requested while rate switching is disabled
+    };
+
+    struct Decision_t {
+        Outcome outcome;
+        int32_t desiredRate;
+        int32_t targetRate; // new target, also set for the early outcomes
+        bool targetChanged;
+        bool blocking; // dbv is in the blocking zone
+        bool updateLastDbv;
+        bool stopQuery;
+        const char* stopReason;
+        bool startQuery;
+        // brightness change passed the threshold of the other direction only
+        bool hysteresisHeld;
+    };
+
+    explicit OperationRatePolicy(Config_t config);
+
+    Decision_t evaluate(const Input_t& input) const;
+
+    const Config_t& getConfig() const { return mConfig; }
+    int32_t getLowestRate() const { return mConfig.rates.front(); }
+    int32_t getHighestRate() const { return mConfig.rates.back(); }
+    // lowest configured rate not below `rate`, the highest rate if none
+    int32_t getRateFor(int32_t rate) const;
+
+private:
+    const Config_t mConfig;
+};
+
+/*
+ * Minimum time to stay in an operation rate before switching to another one. LP, power mode
+ * changes and the blocking zone are not held, so only switches between the configured rates
+ * are delayed.
+ */
+class OperationRateDwellFilter {
+public:
+    struct Config_t {
+        int64_t highestRateMinNs;
+        int64_t lowerRateMinNs;
+    };
+
+    OperationRateDwellFilter(Config_t config, int32_t highestRate);
+
+    /*
+     * Keeps the current target of `decision` if its switch comes too early and returns the
+     * time left, 0 if the decision is not changed. The histogram query of a held decision
+     * follows the rate that is kept: it is not stopped, and started if that rate is not the
+     * desired one.
+     */
+    int64_t hold(const OperationRatePolicy::Input_t& input,
+                 OperationRatePolicy::Decision_t* decision, int64_t nowNs) const;
+    // time left before the current rate may be left, 0 if a switch is allowed now
+    int64_t getRemainingNs(int64_t nowNs) const;
+    void onRateChanged(int32_t rate, int64_t nowNs);
+    bool isEnabled() const { return mConfig.highestRateMinNs || mConfig.lowerRateMinNs; }
+
+private:
+    const Config_t mConfig;
+    const int32_t mHighestRate;
+    int32_t mRate;
+    int64_t mSinceNs;
+};
+
+} // namespace zumapro
+
+#endif // _OPERATION_RATE_POLICY_ZUMAPRO_H
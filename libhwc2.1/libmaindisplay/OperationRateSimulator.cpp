@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OperationRateSimulator.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+using namespace zumapro;
+
+namespace {
+
+OperationRateController::Config_t getControllerConfig(
+        const OperationRateSimulator::Config_t& config) {
+    OperationRateController::Config_t controllerConfig = {};
+    controllerConfig.policy = config.policy;
+    controllerConfig.dwell = config.dwell;
+    controllerConfig.dbvPredictor = config.dbvPredictor;
+    controllerConfig.hasHistogram = config.histogramDeltaThreshold > 0;
+    return controllerConfig;
+}
+
+} // namespace
+
+OperationRateSimulator::OperationRateSimulator(Config_t config)
+      : mConfig(config),
+        mController(getControllerConfig(config)),
+        mQueryMode(false),
+        mPrevLuma(0),
+        mNowNs(0),
+        mReport{},
+        mLastTimeNs(0) {
+    mReport.timeline.emplace_back(0, getOperationRate());
+}
+
+std::optional<OperationRateSimulator::Event_t> OperationRateSimulator::parseEvent(
+        const std::string& line, bool* error) {
+    *error = false;
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line[start] == '#') return std::nullopt;
+
+    std::istringstream in(line);
+    double timeMs;
+    std::string type, value;
+    if (!(in >> timeMs >> type >> value)) {
+        *error = true;
+        return std::nullopt;
+    }
+
+    Event_t event = {};
+    event.timeNs = static_cast<int64_t>(timeMs * 1000000);
+    if (type == "power") {
+        event.type = EventType::POWER;
+        if (value == "on") {
+            event.value = static_cast<float>(OperationRatePolicy::PowerState::ON);
+        } else if (value == "doze" || value == "doze_suspend") {
+            event.value = static_cast<float>(OperationRatePolicy::PowerState::LP);
+        } else if (value == "off") {
+            event.value = static_cast<float>(OperationRatePolicy::PowerState::OFF);
+        } else {
+            *error = true;
+            return std::nullopt;
+        }
+        return event;
+    }
+
+    static const std::map<std::string, EventType> kTypes = {
+            {"config", EventType::CONFIG},
+            {"dbv", EventType::DBV},
+            {"peak", EventType::PEAK_REFRESH_RATE},
+            {"battery", EventType::LOW_BATTERY},
+            {"luma", EventType::LUMA},
+    };
+    auto it = kTypes.find(type);
+    char* end = nullptr;
+    event.value = std::strtof(value.c_str(), &end);
+    if (it == kTypes.end() || *end) {
+        *error = true;
+        return std::nullopt;
+    }
+    event.type = it->second;
+    return event;
+}
+
+int32_t OperationRateSimulator::getOperationRate() const {
+    return mController.getOperationRate();
+}
+
+void OperationRateSimulator::update(OperationRatePolicy::Condition cond) {
+    auto decision = mController.update(cond, mConfig.configSettingEnabled, mNowNs).decision;
+    if (decision.stopQuery) mQueryMode = false;
+    if (decision.startQuery && !mQueryMode) {
+        // the worker forgets the previous luma when it starts a new query
+        mQueryMode = true;
+        mPrevLuma = 0;
+    }
+}
+
+void OperationRateSimulator::record(int64_t timeNs) {
+    int32_t lastRate = mReport.timeline.back().second;
+    if (timeNs > mLastTimeNs) {
+        mReport.timeInRateNs[lastRate] += timeNs - mLastTimeNs;
+        mLastTimeNs = timeNs;
+    }
+    int32_t rate = getOperationRate();
+    if (rate == lastRate) return;
+
+    mReport.timeline.emplace_back(mLastTimeNs, rate);
+    if (lastRate && rate) mReport.switchCnt++;
+}
+
+void OperationRateSimulator::replay(const Event_t& event) {
+    if (mController.isDwellPending() && mController.getDwellDeadlineNs() <= event.timeNs) {
+        mNowNs = mController.getDwellDeadlineNs();
+        record(mNowNs);
+        update(OperationRatePolicy::Condition::DWELL_EXPIRED);
+        record(mNowNs);
+    }
+    mNowNs = event.timeNs;
+    record(event.timeNs);
+
+    int32_t value = static_cast<int32_t>(event.value);
+    switch (event.type) {
+        case EventType::CONFIG:
+            mController.setRefreshRate(value);
+            update(OperationRatePolicy::Condition::SET_CONFIG);
+            break;
+        case EventType::DBV:
+            if (!mController.setDbv(value, mNowNs)) break;
+            if (!mController.getPeakRefreshRate()) {
+                mController.setPeakRefreshRate(mConfig.vendorPeakRefreshRate);
+            }
+            update(OperationRatePolicy::Condition::SET_DBV);
+            break;
+        case EventType::POWER:
+            mController.setPowerState(static_cast<OperationRatePolicy::PowerState>(value));
+            update(OperationRatePolicy::Condition::PANEL_SET_POWER);
+            break;
+        case EventType::PEAK_REFRESH_RATE:
+            mController.setPeakRefreshRate(value);
+            break;
+        case EventType::LOW_BATTERY:
+            mController.setLowBatteryMode(value);
+            break;
+        case EventType::LUMA:
+            if (!mQueryMode) break;
+            if (mPrevLuma && std::fabs(event.value - mPrevLuma) > mConfig.histogramDeltaThreshold) {
+                mQueryMode = false;
+                update(OperationRatePolicy::Condition::HISTOGRAM_DELTA);
+            }
+            mPrevLuma = event.value;
+            break;
+    }
+
+    record(event.timeNs);
+}
+
+OperationRateSimulator::Report_t OperationRateSimulator::finish(int64_t endNs) {
+    if (mController.isDwellPending() && mController.getDwellDeadlineNs() <= endNs) {
+        mNowNs = mController.getDwellDeadlineNs();
+        record(mNowNs);
+        update(OperationRatePolicy::Condition::DWELL_EXPIRED);
+        record(mNowNs);
+    }
+    record(endNs);
+    mReport.durationNs = mLastTimeNs;
+    auto stats = mController.getStats();
+    mReport.dwellHeldCnt = stats.dwellHeldCnt;
+    mReport.hysteresisHeldCnt = stats.hysteresisHeldCnt;
+    mReport.dbvPrediction = mController.getDbvPredictor().getStats();
+    return mReport;
+}
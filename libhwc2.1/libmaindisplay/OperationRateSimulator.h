@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPERATION_RATE_SIMULATOR_ZUMAPRO_H
+#define _OPERATION_RATE_SIMULATOR_ZUMAPRO_H
+
+#include <map>
+#include <optional>
+#include <string>
+
+#include "OperationRateController.h"
+
+namespace zumapro {
+
+/*
+ * Replays event traces through the OperationRateController of OperationRateManager, with the
+ * hooks of the manager and the histogram query worker modeled as a query mode flag checked
+ * on every luma sample. A switch held by the dwell time is applied exactly at its deadline,
+ * as the dwell timer of the manager does without waiting for another frame.
+ */
+class OperationRateSimulator {
+public:
+    struct Config_t {
+        OperationRatePolicy::Config_t policy;
+        OperationRateDwellFilter::Config_t dwell;
+        DbvTrendPredictor::Config_t dbvPredictor;
+        float histogramDeltaThreshold;   // 0 disables the histogram query worker
+        int32_t vendorPeakRefreshRate;   // used until the first peak refresh rate event
+        bool configSettingEnabled;
+    };
+
+    enum class EventType : uint32_t {
+        CONFIG = 0,        // refresh rate in Hz
+        DBV,
+        POWER,             // OperationRatePolicy::PowerState
+        PEAK_REFRESH_RATE, // Hz
+        LOW_BATTERY,       // 0 or 1
+        LUMA,              // histogram mean luma
+    };
+
+    struct Event_t {
+        int64_t timeNs;
+        EventType type;
+        float value;
+    };
+
+    struct Report_t {
+        // operation rate after each change, 0 while the panel is off
+        std::vector<std::pair<int64_t, int32_t>> timeline;
+        uint32_t switchCnt;
+        uint32_t dwellHeldCnt;
+        uint32_t hysteresisHeldCnt;
+        DbvTrendPredictor::Stats_t dbvPrediction;
+        std::map<int32_t, int64_t> timeInRateNs;
+        int64_t durationNs;
+    };
+
+    explicit OperationRateSimulator(Config_t config);
+
+    /*
+     * One event per line as "<time ms> <event> <value>", where event is one of config, dbv,
+     * power (on, off, doze, doze_suspend), peak, battery and luma. Empty lines and lines
+     * starting with '#' return std::nullopt without an error.
+     */
+    static std::optional<Event_t> parseEvent(const std::string& line, bool* error);
+
+    void replay(const Event_t& event);
+    Report_t finish(int64_t endNs);
+
+    int32_t getOperationRate() const;
+
+private:
+    void update(OperationRatePolicy::Condition cond);
+    void record(int64_t timeNs);
+
+    const Config_t mConfig;
+    OperationRateController mController;
+
+    bool mQueryMode;
+    float mPrevLuma;
+    int64_t mNowNs;
+
+    Report_t mReport;
+    int64_t mLastTimeNs;
+};
+
+} // namespace zumapro
+
+#endif // _OPERATION_RATE_SIMULATOR_ZUMAPRO_H
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OperationRateTelemetry.h"
+
+using namespace zumapro;
+
+OperationRateTelemetry::OperationRateTelemetry(const std::vector<int32_t>& rates,
+                                               int32_t lowPowerRate, int64_t nowNs)
+      : mLowestRate(rates.front()),
+        mStartNs(nowNs),
+        mStats{},
+        mRate(0),
+        mRateSinceNs(nowNs),
+        mChangedNs(0),
+        mLatencyCnt(0),
+        mLatencyTotalNs(0),
+        mLatencyMaxNs(0),
+        mLatencyBuckets{} {
+    // off, low power and the configured rates, the last slot takes anything else
+    mStats.rates[mStats.rateCnt++] = 0;
+    mStats.rates[mStats.rateCnt++] = lowPowerRate;
+    for (int32_t rate : rates) {
+        if (mStats.rateCnt == OperationRateStats_t::kMaxRateCnt - 1) break;
+        if (rate != lowPowerRate) mStats.rates[mStats.rateCnt++] = rate;
+    }
+    mStats.rates[mStats.rateCnt++] = -1;
+}
+
+size_t OperationRateTelemetry::getRateSlot(int32_t rate) const {
+    for (size_t i = 0; i < mStats.rateCnt - 1; i++) {
+        if (mStats.rates[i] == rate) return i;
+    }
+    return mStats.rateCnt - 1;
+}
+
+void OperationRateTelemetry::onRateChanged(int32_t rate, OperationRatePolicy::Condition cond,
+                                           int64_t nowNs) {
+    if (rate == mRate) return;
+
+    mStats.residencyNs[getRateSlot(mRate)] += nowNs - mRateSinceNs;
+    size_t condIndex = static_cast<size_t>(cond);
+    if (condIndex < OperationRateStats_t::kConditionCnt) {
+        mStats.switchCnt[condIndex]++;
+        if (mRate == mLowestRate) mStats.leaveLowestCnt[condIndex]++;
+    }
+    mRate = rate;
+    mRateSinceNs = nowNs;
+    // nothing to apply while the panel is off
+    mChangedNs.store(rate ? nowNs : 0, std::memory_order_relaxed);
+}
+
+void OperationRateTelemetry::onRateApplied(int64_t nowNs) {
+    int64_t changedNs = mChangedNs.exchange(0, std::memory_order_relaxed);
+    if (!changedNs) return;
+
+    int64_t latencyNs = nowNs - changedNs;
+    mLatencyCnt.fetch_add(1, std::memory_order_relaxed);
+    mLatencyTotalNs.fetch_add(latencyNs, std::memory_order_relaxed);
+    int64_t maxNs = mLatencyMaxNs.load(std::memory_order_relaxed);
+    while (latencyNs > maxNs &&
+           !mLatencyMaxNs.compare_exchange_weak(maxNs, latencyNs, std::memory_order_relaxed)) {
+    }
+
+    size_t bucket = 0;
+    for (int64_t limitMs = 1; bucket < OperationRateStats_t::kLatencyBucketCnt - 1 &&
+         latencyNs >= limitMs * 1000000;
+         limitMs <<= 1) {
+        bucket++;
+    }
+    mLatencyBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void OperationRateTelemetry::getStats(OperationRateStats_t* stats, int64_t nowNs) const {
+    *stats = mStats;
+    stats->durationNs = nowNs - mStartNs;
+    stats->residencyNs[getRateSlot(mRate)] += nowNs - mRateSinceNs;
+    stats->latencyCnt = mLatencyCnt.load(std::memory_order_relaxed);
+    stats->latencyTotalNs = mLatencyTotalNs.load(std::memory_order_relaxed);
+    stats->latencyMaxNs = mLatencyMaxNs.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < OperationRateStats_t::kLatencyBucketCnt; i++) {
+        stats->latencyBuckets[i] = mLatencyBuckets[i].load(std::memory_order_relaxed);
+    }
+}
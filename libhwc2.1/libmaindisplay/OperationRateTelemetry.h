@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPERATION_RATE_TELEMETRY_ZUMAPRO_H
+#define _OPERATION_RATE_TELEMETRY_ZUMAPRO_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "OperationRatePolicy.h"
+
+namespace zumapro {
+
+/* plain copy of OperationRateTelemetry for dump and stats pulls */
+struct OperationRateStats_t {
+    static constexpr size_t kMaxRateCnt = 12;
+    static constexpr size_t kConditionCnt =
+            static_cast<size_t>(OperationRatePolicy::Condition::MAX);
+    // bucket i counts latencies below 2^i ms, the last one everything above
+    static constexpr size_t kLatencyBucketCnt = 12;
+
+    int64_t durationNs;
+    uint32_t rateCnt;
+    std::array<int32_t, kMaxRateCnt> rates; // 0 is the panel being off
+    std::array<int64_t, kMaxRateCnt> residencyNs;
+    std::array<uint64_t, kConditionCnt> switchCnt;
+    // switches away from the lowest rate, by the condition that triggered them
+    std::array<uint64_t, kConditionCnt> leaveLowestCnt;
+
+    uint64_t latencyCnt;
+    int64_t latencyTotalNs;
+    int64_t latencyMaxNs;
+    std::array<uint64_t, kLatencyBucketCnt> latencyBuckets;
+};
+
+/*
+ * Residency, switch reasons and switch latency of the operation rate, in fixed arrays so
+ * nothing is allocated after construction. onRateChanged() and getStats() must be
+ * serialized by the caller, onRateApplied() may be called from any thread.
+ */
+class OperationRateTelemetry {
+public:
+    OperationRateTelemetry(const std::vector<int32_t>& rates, int32_t lowPowerRate,
+                           int64_t nowNs);
+
+    void onRateChanged(int32_t rate, OperationRatePolicy::Condition cond, int64_t nowNs);
+    bool isApplyPending() const { return mChangedNs.load(std::memory_order_relaxed) != 0; }
+    // the new rate was read by the commit path
+    void onRateApplied(int64_t nowNs);
+    void getStats(OperationRateStats_t* stats, int64_t nowNs) const;
+
+private:
+    size_t getRateSlot(int32_t rate) const;
+
+    const int32_t mLowestRate;
+    const int64_t mStartNs;
+    OperationRateStats_t mStats;
+    int32_t mRate;
+    int64_t mRateSinceNs;
+
+    std::atomic<int64_t> mChangedNs;
+    std::atomic<uint64_t> mLatencyCnt;
+    std::atomic<int64_t> mLatencyTotalNs;
+    std::atomic<int64_t> mLatencyMaxNs;
+    std::array<std::atomic<uint64_t>, OperationRateStats_t::kLatencyBucketCnt> mLatencyBuckets;
+};
+
+} // namespace zumapro
+
+#endif // _OPERATION_RATE_TELEMETRY_ZUMAPRO_H
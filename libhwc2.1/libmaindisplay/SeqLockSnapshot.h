@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SEQLOCK_SNAPSHOT_ZUMAPRO_H
+#define _SEQLOCK_SNAPSHOT_ZUMAPRO_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace zumapro {
+
+/*
+ * Versioned copy of a small trivially copyable struct. Writers must be serialized by the
+ * caller; readers never block and retry only while a store is in progress. The payload is
+ * kept in atomic words so a torn read is never a data race, only a retry. The words are
+ * stored with release and loaded with acquire instead of using standalone fences, which
+ * keeps the ordering visible to TSan and costs only stlr/ldar on arm64.
+ */
+template <typename T>
+class SeqLockSnapshot {
+    static_assert(std::is_trivially_copyable_v<T>, "snapshot must be trivially copyable");
+
+public:
+    explicit SeqLockSnapshot(const T& value = T{}) { store(value); }
+
+    void store(const T& value) {
+        std::array<uint32_t, kWordCnt> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        uint32_t seq = mSeq.load(std::memory_order_relaxed);
+        mSeq.store(seq + 1, std::memory_order_relaxed);
+        for (size_t i = 0; i < kWordCnt; i++) {
+            mWords[i].store(words[i], std::memory_order_release);
+        }
+        mSeq.store(seq + 2, std::memory_order_release);
+    }
+
+    T load(uint32_t* version = nullptr) const {
+        std::array<uint32_t, kWordCnt> words;
+        uint32_t begin, end;
+        do {
+            begin = mSeq.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWordCnt; i++) {
+                words[i] = mWords[i].load(std::memory_order_acquire);
+            }
+            end = mSeq.load(std::memory_order_relaxed);
+        } while ((begin & 1) || begin != end);
+
+        T value;
+        std::memcpy(&value, words.data(), sizeof(T));
+        if (version) *version = begin / 2;
+        return value;
+    }
+
+private:
+    static constexpr size_t kWordCnt = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> mSeq{0};
+    std::array<std::atomic<uint32_t>, kWordCnt> mWords{};
+};
+
+} // namespace zumapro
+
+#endif // _SEQLOCK_SNAPSHOT_ZUMAPRO_H
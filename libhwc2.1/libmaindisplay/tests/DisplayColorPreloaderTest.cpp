@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <dlfcn.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "DisplayColorPreloader.h"
+
+using namespace zumapro;
+
+namespace {
+
+using State = DisplayColorPreloader::State;
+
+constexpr int64_t kStubLoadNs = 50 * 1000000;
+
+/* the stub library is installed next to the test, under lib64/ on hosts */
+std::string getStubPath() {
+    auto dir = std::filesystem::read_symlink("/proc/self/exe").parent_path();
+    for (auto path : {dir / "lib64", dir}) {
+        path /= "libzumapro_stub_displaycolor.so";
+        if (std::filesystem::exists(path)) return path;
+    }
+    return {};
+}
+
+bool isResident(const std::string& path) {
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_NOLOAD);
+    if (!handle) return false;
+    dlclose(handle);
+    return true;
+}
+
+} // namespace
+
+TEST(DisplayColorPreloaderTest, PublishesTheHandleWhenReady) {
+    std::string path = getStubPath();
+    ASSERT_FALSE(path.empty());
+    ASSERT_FALSE(isResident(path));
+    {
+        DisplayColorPreloader preloader(path.c_str());
+        // the handle is only published once the library is mapped
+        if (preloader.getState() == State::LOADING) {
+            EXPECT_EQ(preloader.getHandle(), nullptr);
+        }
+        preloader.wait();
+        ASSERT_EQ(preloader.getState(), State::READY);
+        ASSERT_NE(preloader.getHandle(), nullptr);
+        EXPECT_GE(preloader.getLoadNs(), kStubLoadNs);
+
+        auto getLoadCnt = reinterpret_cast<int (*)()>(
+                dlsym(preloader.getHandle(), "GetStubDisplayColorLoadCnt"));
+        ASSERT_NE(getLoadCnt, nullptr);
+        EXPECT_EQ(getLoadCnt(), 1);
+        // the synchronous load of the device module only takes another reference
+        EXPECT_TRUE(isResident(path));
+    }
+    // the reference of the preload is dropped with the preloader
+    EXPECT_FALSE(isResident(path));
+}
+
+TEST(DisplayColorPreloaderTest, ReportsAMissingLibrary) {
+    DisplayColorPreloader preloader("libzumapro_missing_displaycolor.so");
+    preloader.wait();
+    EXPECT_EQ(preloader.getState(), State::FAILED);
+    EXPECT_EQ(preloader.getHandle(), nullptr);
+    EXPECT_FALSE(preloader.getError().empty());
+}
+
+TEST(DisplayColorPreloaderTest, DestructionWaitsForTheLoad) {
+    std::string path = getStubPath();
+    ASSERT_FALSE(path.empty());
+    // destroyed while the library is still being mapped
+    { DisplayColorPreloader preloader(path.c_str()); }
+    EXPECT_FALSE(isResident(path));
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "HistogramQueryBuffer.h"
+
+namespace {
+
+std::atomic<uint64_t> gAllocationCnt{0};
+
+} // namespace
+
+void* operator new(size_t size) {
+    gAllocationCnt++;
+    if (void* ptr = malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+// out of line so that the compiler does not pair the inlined free() with operator new
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+using namespace zumapro;
+
+namespace {
+
+/*
+ * A controller that copies into the caller's vector in place. The buffer only saves
+ * allocations with such a controller, getReallocCnt() tells on the device.
+ */
+class FakeHistogramController {
+public:
+    explicit FakeHistogramController(size_t binCnt, bool replace = false)
+          : mBins(binCnt), mReplace(replace) {}
+
+    void collect(uint32_t frame) {
+        for (size_t i = 0; i < mBins.size(); i++) mBins[i] = (i * 31 + frame) % 4096;
+    }
+    void queryHistogram(std::vector<char16_t>* histogramBuffer) const {
+        if (mReplace) {
+            // a histogram built in a local vector and moved out
+            std::vector<char16_t> bins(mBins);
+            *histogramBuffer = std::move(bins);
+            return;
+        }
+        histogramBuffer->assign(mBins.begin(), mBins.end());
+    }
+
+private:
+    std::vector<char16_t> mBins;
+    bool mReplace;
+};
+
+/* HistogramQueryWorker::Routine() from the query to the statistics */
+bool query(const FakeHistogramController& controller, HistogramQueryBuffer& buffer,
+           HistogramStats_t* stats) {
+    controller.queryHistogram(buffer.prepare());
+    buffer.updateCapacity();
+    return !buffer.empty() && buffer.computeStats(stats);
+}
+
+} // namespace
+
+TEST(HistogramQueryBufferTest, SteadyStateDoesNotAllocate) {
+    FakeHistogramController controller(256);
+    HistogramQueryBuffer buffer;
+    HistogramStats_t stats;
+
+    uint64_t allocationCnt = gAllocationCnt;
+    for (uint32_t frame = 0; frame < 1000; frame++) {
+        controller.collect(frame);
+        ASSERT_TRUE(query(controller, buffer, &stats));
+    }
+    EXPECT_EQ(gAllocationCnt - allocationCnt, 0u);
+    EXPECT_EQ(buffer.getCapacity(), kHistogramStatsMaxBins);
+    EXPECT_EQ(buffer.getQueryCnt(), 1000u);
+    EXPECT_EQ(buffer.getReallocCnt(), 0u);
+}
+
+TEST(HistogramQueryBufferTest, GrowsOnceForLargerHistograms) {
+    FakeHistogramController controller(kHistogramStatsMaxBins * 2);
+    HistogramQueryBuffer buffer;
+    HistogramStats_t stats;
+
+    // too many bins for the statistics, but the buffer keeps the larger size
+    uint64_t allocationCnt = gAllocationCnt;
+    EXPECT_FALSE(query(controller, buffer, &stats));
+    EXPECT_EQ(buffer.getCapacity(), kHistogramStatsMaxBins * 2);
+    EXPECT_EQ(gAllocationCnt - allocationCnt, 1u);
+
+    allocationCnt = gAllocationCnt;
+    for (uint32_t frame = 0; frame < 100; frame++) query(controller, buffer, &stats);
+    EXPECT_EQ(gAllocationCnt - allocationCnt, 0u);
+    EXPECT_EQ(buffer.getReallocCnt(), 1u);
+}
+
+TEST(HistogramQueryBufferTest, CountsReplacedStorage) {
+    // a controller that moves its own vector out gives up the reserved storage
+    FakeHistogramController controller(256, true);
+    HistogramQueryBuffer buffer;
+    HistogramStats_t stats;
+    controller.collect(0);
+
+    uint64_t allocationCnt = gAllocationCnt;
+    ASSERT_TRUE(query(controller, buffer, &stats));
+    EXPECT_EQ(buffer.getReallocCnt(), 1u);
+    EXPECT_EQ(gAllocationCnt - allocationCnt, 1u);
+}
+
+TEST(HistogramQueryBufferTest, CountsAllocations) {
+    // a controller replacing the vector would allocate on every query
+    HistogramQueryBuffer buffer;
+    uint64_t allocationCnt = gAllocationCnt;
+    for (int i = 0; i < 10; i++) *buffer.prepare() = std::vector<char16_t>(256, 1);
+    EXPECT_EQ(gAllocationCnt - allocationCnt, 10u);
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "HistogramRoiTracker.h"
+
+using namespace zumapro;
+
+namespace {
+
+using Rect_t = HistogramRoiTracker::Rect_t;
+
+constexpr int32_t kWidth = 1080;
+constexpr int32_t kHeight = 2400;
+constexpr uint32_t kStableFrames = 30;
+constexpr int64_t kBasePeriodNs = 100;
+constexpr int64_t kMaxPeriodNs = 800;
+
+const Rect_t kScreen = {0, 0, kWidth, kHeight};
+const Rect_t kVideo = {0, 600, kWidth, 1200};
+
+HistogramRoiTracker::Config_t getConfig() {
+    return {kStableFrames, 50, kBasePeriodNs, kMaxPeriodNs};
+}
+
+/* queries until the tracker skips one, the damage of the last frame is in the histogram */
+void drainQueries(HistogramRoiTracker& tracker) {
+    HistogramRoiTracker::Query_t query;
+    while (tracker.getNextQuery(&query)) {
+    }
+}
+
+} // namespace
+
+TEST(HistogramRoiTrackerTest, RectUnionAndContains) {
+    Rect_t rect = {};
+    EXPECT_TRUE(rect.isEmpty());
+    EXPECT_EQ(rect.getArea(), 0);
+    rect.unite({10, 10, 20, 20});
+    EXPECT_EQ(rect, (Rect_t{10, 10, 20, 20}));
+    rect.unite({});
+    EXPECT_EQ(rect, (Rect_t{10, 10, 20, 20}));
+    rect.unite({0, 15, 15, 40});
+    EXPECT_EQ(rect, (Rect_t{0, 10, 20, 40}));
+    EXPECT_EQ(rect.getArea(), 600);
+    EXPECT_TRUE(rect.contains({5, 10, 20, 40}));
+    EXPECT_FALSE(rect.contains({5, 10, 21, 40}));
+}
+
+TEST(HistogramRoiTrackerTest, EmptyDamageSkipsQueriesAndBacksOff) {
+    HistogramRoiTracker tracker(getConfig());
+    HistogramRoiTracker::Query_t query;
+    EXPECT_FALSE(tracker.onFrame({}, kWidth, kHeight));
+
+    // the first queries are unconditional, then nothing can have changed
+    EXPECT_TRUE(tracker.getNextQuery(&query));
+    EXPECT_TRUE(query.roi.isEmpty());
+    EXPECT_EQ(query.areaRatio, 1.0f);
+    EXPECT_TRUE(tracker.getNextQuery(&query));
+    for (int64_t periodNs : {200, 400, 800, 800}) {
+        EXPECT_FALSE(tracker.onFrame({}, kWidth, kHeight));
+        EXPECT_FALSE(tracker.getNextQuery(&query));
+        EXPECT_EQ(tracker.getPeriodNs(), periodNs);
+    }
+
+    // damage wakes the backed off worker and needs two queries to be seen
+    EXPECT_TRUE(tracker.onFrame(kVideo, kWidth, kHeight));
+    EXPECT_EQ(tracker.getPeriodNs(), kBasePeriodNs);
+    EXPECT_FALSE(tracker.onFrame(kVideo, kWidth, kHeight));
+    EXPECT_TRUE(tracker.getNextQuery(&query));
+    EXPECT_TRUE(tracker.getNextQuery(&query));
+    EXPECT_FALSE(tracker.getNextQuery(&query));
+
+    auto stats = tracker.getStats();
+    EXPECT_EQ(stats.frameCnt, 7u);
+    EXPECT_EQ(stats.damagedFrameCnt, 2u);
+    EXPECT_EQ(stats.queryCnt, 4u);
+    EXPECT_EQ(stats.skippedCnt, 5u);
+}
+
+TEST(HistogramRoiTrackerTest, FullScreenDamageKeepsFullScreenRoi) {
+    HistogramRoiTracker tracker(getConfig());
+    HistogramRoiTracker::Query_t query;
+    for (uint32_t i = 0; i < kStableFrames * 3; i++) {
+        tracker.onFrame(kScreen, kWidth, kHeight);
+        ASSERT_TRUE(tracker.getNextQuery(&query));
+        EXPECT_TRUE(query.roi.isEmpty());
+        EXPECT_EQ(query.areaRatio, 1.0f);
+    }
+    EXPECT_EQ(tracker.getStats().roiChangeCnt, 0u);
+}
+
+TEST(HistogramRoiTrackerTest, RoiShrinksOnlyAfterStableDamage) {
+    HistogramRoiTracker tracker(getConfig());
+    HistogramRoiTracker::Query_t query;
+    for (uint32_t i = 1; i < kStableFrames; i++) {
+        tracker.onFrame(kVideo, kWidth, kHeight);
+        ASSERT_TRUE(tracker.getNextQuery(&query));
+        EXPECT_TRUE(query.roi.isEmpty()) << "frame " << i;
+    }
+    tracker.onFrame(kVideo, kWidth, kHeight);
+    ASSERT_TRUE(tracker.getNextQuery(&query));
+    EXPECT_EQ(query.roi, kVideo);
+    EXPECT_FLOAT_EQ(query.areaRatio, 0.25f);
+
+    // damage inside the roi keeps it
+    tracker.onFrame({100, 700, 200, 800}, kWidth, kHeight);
+    ASSERT_TRUE(tracker.getNextQuery(&query));
+    EXPECT_EQ(query.roi, kVideo);
+
+    // the first damage outside returns to full screen and starts the next window
+    tracker.onFrame({0, 1300, 10, 1310}, kWidth, kHeight);
+    ASSERT_TRUE(tracker.getNextQuery(&query));
+    EXPECT_TRUE(query.roi.isEmpty());
+    for (uint32_t i = 2; i < kStableFrames; i++) {
+        tracker.onFrame(kVideo, kWidth, kHeight);
+        ASSERT_TRUE(tracker.getNextQuery(&query));
+        EXPECT_TRUE(query.roi.isEmpty()) << "frame " << i;
+    }
+    tracker.onFrame(kVideo, kWidth, kHeight);
+    ASSERT_TRUE(tracker.getNextQuery(&query));
+    EXPECT_EQ(query.roi, (Rect_t{0, 600, kWidth, 1310}));
+    EXPECT_EQ(tracker.getStats().roiChangeCnt, 3u);
+}
+
+TEST(HistogramRoiTrackerTest, ResetResolutionAndDisable) {
+    HistogramRoiTracker tracker(getConfig());
+    HistogramRoiTracker::Query_t query;
+    for (uint32_t i = 0; i < kStableFrames; i++) tracker.onFrame(kVideo, kWidth, kHeight);
+    drainQueries(tracker);
+    tracker.onFrame(kVideo, kWidth, kHeight);
+    ASSERT_TRUE(tracker.getNextQuery(&query));
+    EXPECT_EQ(query.roi, kVideo);
+
+    // a new query run starts from full screen and queries unconditionally
+    tracker.reset();
+    ASSERT_TRUE(tracker.getNextQuery(&query));
+    EXPECT_TRUE(query.roi.isEmpty());
+
+    // the roi is in the coordinates of the old resolution
+    for (uint32_t i = 0; i < kStableFrames; i++) tracker.onFrame(kVideo, kWidth, kHeight);
+    drainQueries(tracker);
+    tracker.onFrame({100, 700, 200, 800}, kWidth / 2, kHeight / 2);
+    ASSERT_TRUE(tracker.getNextQuery(&query));
+    EXPECT_TRUE(query.roi.isEmpty());
+
+    tracker.disableRoi();
+    for (uint32_t i = 0; i < kStableFrames * 2; i++) {
+        tracker.onFrame({0, 0, 10, 10}, kWidth / 2, kHeight / 2);
+        ASSERT_TRUE(tracker.getNextQuery(&query));
+        EXPECT_TRUE(query.roi.isEmpty());
+    }
+}
+
+TEST(HistogramRoiTrackerTest, StaysFullScreenWithoutStableFrames) {
+    auto config = getConfig();
+    config.stableFrames = 0;
+    HistogramRoiTracker tracker(config);
+    HistogramRoiTracker::Query_t query;
+    for (uint32_t i = 0; i < kStableFrames * 2; i++) {
+        tracker.onFrame({0, 0, 10, 10}, kWidth, kHeight);
+        ASSERT_TRUE(tracker.getNextQuery(&query));
+        EXPECT_TRUE(query.roi.isEmpty());
+    }
+}
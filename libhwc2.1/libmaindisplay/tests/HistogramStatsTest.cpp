@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "HistogramStats.h"
+
+using namespace zumapro;
+
+namespace {
+
+enum class Content { DENSE, SPARSE, SINGLE };
+
+std::vector<char16_t> makeBins(std::mt19937& rng, size_t size, Content content) {
+    std::vector<char16_t> bins(size);
+    for (auto& bin : bins) {
+        switch (content) {
+            case Content::DENSE:
+                bin = rng() % 65536;
+                break;
+            case Content::SPARSE:
+                bin = (rng() % 10 == 0) ? rng() % 65536 : 0;
+                break;
+            case Content::SINGLE:
+                bin = 0;
+                break;
+        }
+    }
+    if (content == Content::SINGLE) bins[rng() % size] = 1 + rng() % 65535;
+    return bins;
+}
+
+/* first bin where the cumulative count reaches the percentile */
+uint32_t findPercentile(const std::vector<char16_t>& bins, uint64_t count, uint32_t percent) {
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < bins.size(); i++) {
+        cumulative += bins[i];
+        if (cumulative * 100 >= count * percent) return i;
+    }
+    return bins.size() - 1;
+}
+
+} // namespace
+
+TEST(HistogramStatsTest, VectorMatchesScalar) {
+    std::mt19937 rng(1);
+    for (int run = 0; run < 20000; run++) {
+        // the histogram sizes of the DPU, then any size up to the limit
+        size_t size = (run % 3 == 0) ? 256 : (run % 3 == 1) ? 1024 : 1 + rng() % 1024;
+        auto content = static_cast<Content>(rng() % 3);
+        auto bins = makeBins(rng, size, content);
+
+        HistogramStats_t vector = {};
+        HistogramStats_t scalar = {};
+        if (std::all_of(bins.begin(), bins.end(), [](char16_t bin) { return !bin; })) {
+            // a small sparse histogram can be empty
+            EXPECT_FALSE(computeHistogramStats(bins.data(), size, &vector)) << "run " << run;
+            EXPECT_FALSE(computeHistogramStatsScalar(bins.data(), size, &scalar)) << "run " << run;
+            continue;
+        }
+        ASSERT_TRUE(computeHistogramStats(bins.data(), size, &vector)) << "run " << run;
+        ASSERT_TRUE(computeHistogramStatsScalar(bins.data(), size, &scalar)) << "run " << run;
+
+        EXPECT_EQ(vector.count, scalar.count) << "run " << run;
+        EXPECT_EQ(vector.mean, scalar.mean) << "run " << run;
+        EXPECT_EQ(vector.variance, scalar.variance) << "run " << run;
+        EXPECT_EQ(vector.percentiles, scalar.percentiles) << "run " << run;
+
+        double sum = 0, sumSq = 0;
+        for (size_t i = 0; i < size; i++) {
+            sum += static_cast<double>(i) * bins[i];
+            sumSq += static_cast<double>(i) * i * bins[i];
+        }
+        double mean = sum / vector.count;
+        double variance = sumSq / vector.count - mean * mean;
+        EXPECT_NEAR(vector.mean, mean, 1e-3 * std::max(1.0, mean)) << "run " << run;
+        EXPECT_NEAR(vector.variance, variance, 1e-3 * std::max(1.0, variance)) << "run " << run;
+        for (size_t p = 0; p < kHistogramPercentiles.size(); p++) {
+            EXPECT_EQ(vector.percentiles[p],
+                      findPercentile(bins, vector.count, kHistogramPercentiles[p]))
+                    << "run " << run << " percentile " << kHistogramPercentiles[p];
+        }
+        if (HasFailure()) return;
+    }
+}
+
+TEST(HistogramStatsTest, RejectsInvalidHistograms) {
+    std::vector<char16_t> bins(kHistogramStatsMaxBins + 8, 1);
+    HistogramStats_t stats;
+    EXPECT_FALSE(computeHistogramStats(bins.data(), 0, &stats));
+    EXPECT_FALSE(computeHistogramStats(bins.data(), bins.size(), &stats));
+    EXPECT_FALSE(computeHistogramStatsScalar(bins.data(), bins.size(), &stats));
+
+    std::fill(bins.begin(), bins.end(), 0);
+    EXPECT_FALSE(computeHistogramStats(bins.data(), 256, &stats));
+    EXPECT_FALSE(computeHistogramStatsScalar(bins.data(), 256, &stats));
+}
+
+TEST(HistogramStatsTest, SaturatedBins) {
+    // the largest sums the accumulators have to hold
+    std::vector<char16_t> bins(kHistogramStatsMaxBins, 0xFFFF);
+    HistogramStats_t vector, scalar;
+    ASSERT_TRUE(computeHistogramStats(bins.data(), bins.size(), &vector));
+    ASSERT_TRUE(computeHistogramStatsScalar(bins.data(), bins.size(), &scalar));
+    EXPECT_EQ(vector.count, 0xFFFFull * kHistogramStatsMaxBins);
+    EXPECT_EQ(vector.mean, scalar.mean);
+    EXPECT_EQ(vector.variance, scalar.variance);
+    EXPECT_EQ(vector.percentiles, scalar.percentiles);
+}
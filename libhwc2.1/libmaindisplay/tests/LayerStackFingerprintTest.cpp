@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <vector>
+
+#include "LayerStackFingerprint.h"
+
+using namespace zumapro;
+
+namespace {
+
+constexpr uint32_t kXres = 1344;
+constexpr uint32_t kYres = 2992;
+
+struct Display {
+    uint32_t config = 0;
+    uint64_t colorGeneration = 1;
+    std::vector<LayerStackKey_t> layers;
+    // last fingerprint of checkPreblendingRequirement()
+    std::optional<uint64_t> cached;
+    uint32_t hitCnt = 0;
+    uint32_t missCnt = 0;
+
+    uint64_t getFingerprint() const {
+        LayerStackFingerprint fingerprint(layers.size(), config, kXres, kYres, colorGeneration);
+        for (const auto& layer : layers) fingerprint.addLayer(layer);
+        return fingerprint.get();
+    }
+
+    // the layer stack cache of ExynosPrimaryDisplayModule
+    void validate() {
+        uint64_t fingerprint = getFingerprint();
+        if (cached == fingerprint) {
+            hitCnt++;
+        } else {
+            missCnt++;
+            cached = fingerprint;
+        }
+    }
+};
+
+LayerStackKey_t makeLayer(int32_t top, int32_t bottom) {
+    return {{0.0f, 0.0f, kXres, static_cast<float>(bottom - top)},
+            {0, top, kXres, bottom},
+            0,
+            0,
+            1,
+            0,
+            false,
+            1.0f,
+            0,
+            0};
+}
+
+Display makeDisplay() {
+    Display display;
+    display.layers = {makeLayer(0, 2992), makeLayer(0, 100), makeLayer(2800, 2992)};
+    return display;
+}
+
+} // namespace
+
+TEST(LayerStackFingerprintTest, SameStackHits) {
+    Display display = makeDisplay();
+    // only the buffers change, they are not part of the fingerprint
+    for (int i = 0; i < 10; i++) display.validate();
+    EXPECT_EQ(display.missCnt, 1u);
+    EXPECT_EQ(display.hitCnt, 9u);
+}
+
+TEST(LayerStackFingerprintTest, LayerChangesMiss) {
+    const std::vector<void (*)(LayerStackKey_t&)> changes = {
+            [](LayerStackKey_t& layer) { layer.sourceCrop[2] -= 0.5f; },
+            [](LayerStackKey_t& layer) { layer.displayFrame[1] += 1; },
+            [](LayerStackKey_t& layer) { layer.transform = 4; },
+            [](LayerStackKey_t& layer) { layer.dataspace = 0x08C20000; },
+            [](LayerStackKey_t& layer) { layer.format = 0x2B; },
+            [](LayerStackKey_t& layer) { layer.compression = 1; },
+            [](LayerStackKey_t& layer) { layer.hdr = true; },
+            [](LayerStackKey_t& layer) { layer.brightness = 0.5f; },
+            [](LayerStackKey_t& layer) {
+                const float mat[16] = {0.5f, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+                layer.colorTransform = LayerStackFingerprint::hashBytes(mat, sizeof(mat));
+            },
+            [](LayerStackKey_t& layer) {
+                const uint32_t maxLuminance = 1000;
+                layer.hdrMetadata =
+                        LayerStackFingerprint::hashBytes(&maxLuminance, sizeof(maxLuminance));
+            },
+    };
+    for (size_t i = 0; i < changes.size(); i++) {
+        Display display = makeDisplay();
+        display.validate();
+        changes[i](display.layers[1]);
+        display.validate();
+        display.validate();
+        EXPECT_EQ(display.missCnt, 2u) << "change " << i;
+        EXPECT_EQ(display.hitCnt, 1u) << "change " << i;
+    }
+}
+
+TEST(LayerStackFingerprintTest, DisplayChangesMiss) {
+    Display display = makeDisplay();
+    display.validate();
+
+    // a color mode, color transform, power mode or brightness change bumps the generation
+    display.colorGeneration++;
+    display.validate();
+    EXPECT_EQ(display.missCnt, 2u);
+
+    display.config++;
+    display.validate();
+    EXPECT_EQ(display.missCnt, 3u);
+
+    display.layers.pop_back();
+    display.validate();
+    EXPECT_EQ(display.missCnt, 4u);
+
+    // the same layers in another z-order are another stack
+    std::swap(display.layers[0], display.layers[1]);
+    display.validate();
+    EXPECT_EQ(display.missCnt, 5u);
+    EXPECT_EQ(display.hitCnt, 0u);
+}
+
+TEST(LayerStackFingerprintTest, MetadataHash) {
+    float mat[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    uint64_t identity = LayerStackFingerprint::hashBytes(mat, sizeof(mat));
+    EXPECT_NE(identity, 0u);
+    EXPECT_EQ(identity, LayerStackFingerprint::hashBytes(mat, sizeof(mat)));
+
+    // a new value of any coefficient or a new metadata block is another stack
+    mat[15] = 0.99f;
+    EXPECT_NE(identity, LayerStackFingerprint::hashBytes(mat, sizeof(mat)));
+    EXPECT_NE(LayerStackFingerprint::hashBytes(mat, sizeof(mat)),
+              LayerStackFingerprint::hashBytes(mat, sizeof(mat), identity));
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "OperationRateController.h"
+#include "OperationRateSimulator.h"
+
+using namespace zumapro;
+
+namespace {
+
+using Condition = OperationRatePolicy::Condition;
+using PowerState = OperationRatePolicy::PowerState;
+
+constexpr int64_t kMsNs = 1000000;
+
+OperationRateController::Config_t getConfig() {
+    OperationRateController::Config_t config = {};
+    config.policy.rates = {60, 120};
+    config.policy.lowPowerRate = 30;
+    config.policy.brightnessDeltaUpThreshold = 10;
+    config.policy.brightnessDeltaDownThreshold = 10;
+    config.dbvPredictor.maxStepNs = 200 * kMsNs;
+    return config;
+}
+
+} // namespace
+
+TEST(OperationRateControllerTest, StartsLikeTheManager) {
+    OperationRateController controller(getConfig());
+    EXPECT_EQ(controller.getPowerState(), PowerState::ON);
+    EXPECT_EQ(controller.getTargetRate(), 120);
+    EXPECT_EQ(controller.getOperationRate(), 120);
+
+    // a hook before the first power mode switches right away
+    controller.setPeakRefreshRate(60);
+    controller.setRefreshRate(60);
+    ASSERT_TRUE(controller.setDbv(500, 0));
+    auto update = controller.update(Condition::SET_DBV, true, 0);
+    EXPECT_TRUE(update.decision.targetChanged);
+    EXPECT_EQ(controller.getOperationRate(), 60);
+    EXPECT_EQ(controller.getLastDbv(), 500);
+    EXPECT_FALSE(controller.setDbv(500, kMsNs));
+    EXPECT_FALSE(controller.setDbv(0, kMsNs));
+}
+
+TEST(OperationRateControllerTest, HoldsSwitchesForTheDwellTime) {
+    auto config = getConfig();
+    config.dwell.highestRateMinNs = 500 * kMsNs;
+    OperationRateController controller(config);
+    controller.setPeakRefreshRate(60);
+    controller.setRefreshRate(60);
+
+    ASSERT_TRUE(controller.setDbv(500, 100 * kMsNs));
+    auto update = controller.update(Condition::SET_DBV, true, 100 * kMsNs);
+    EXPECT_EQ(update.heldRate, 60);
+    EXPECT_EQ(update.heldNs, 400 * kMsNs);
+    EXPECT_FALSE(update.decision.targetChanged);
+    EXPECT_EQ(controller.getTargetRate(), 120);
+    EXPECT_TRUE(controller.isDwellPending());
+    EXPECT_EQ(controller.getDwellDeadlineNs(), 500 * kMsNs);
+
+    update = controller.update(Condition::DWELL_EXPIRED, true, 500 * kMsNs);
+    EXPECT_TRUE(update.decision.targetChanged);
+    EXPECT_EQ(controller.getTargetRate(), 60);
+    EXPECT_FALSE(controller.isDwellPending());
+    auto stats = controller.getStats();
+    EXPECT_EQ(stats.dwellHeldCnt, 1u);
+    EXPECT_EQ(stats.dwellAppliedCnt, 1u);
+}
+
+TEST(OperationRateControllerTest, HeldSwitchAppliedWithNoFurtherFrames) {
+    auto config = getConfig();
+    config.dwell.highestRateMinNs = 500 * kMsNs;
+    OperationRateController controller(config);
+    controller.setPeakRefreshRate(60);
+    controller.setRefreshRate(60);
+    EXPECT_EQ(controller.getDwellWaitNs(0), -1);
+
+    // the last hook of a static screen holds the switch
+    ASSERT_TRUE(controller.setDbv(500, 100 * kMsNs));
+    ASSERT_EQ(controller.update(Condition::SET_DBV, true, 100 * kMsNs).heldRate, 60);
+
+    // the dwell timer of the manager, with no frame or hook in between
+    int64_t nowNs = 100 * kMsNs;
+    int wakeCnt = 0;
+    for (int64_t waitNs; (waitNs = controller.getDwellWaitNs(nowNs)) >= 0; wakeCnt++) {
+        ASSERT_LT(wakeCnt, 2);
+        nowNs += waitNs;
+        if (waitNs) continue;
+        EXPECT_TRUE(controller.update(Condition::DWELL_EXPIRED, true, nowNs)
+                            .decision.targetChanged);
+    }
+    EXPECT_EQ(nowNs, 500 * kMsNs);
+    EXPECT_EQ(controller.getTargetRate(), 60);
+    EXPECT_EQ(controller.getStats().dwellAppliedCnt, 1u);
+
+    // the simulator applies it at the deadline as well
+    OperationRateSimulator::Config_t simConfig = {};
+    simConfig.policy = config.policy;
+    simConfig.dwell = config.dwell;
+    simConfig.dbvPredictor = config.dbvPredictor;
+    simConfig.vendorPeakRefreshRate = 60;
+    simConfig.configSettingEnabled = true;
+    OperationRateSimulator simulator(simConfig);
+    bool error;
+    for (const char* line : {"10 config 60", "100 dbv 500"}) {
+        auto event = OperationRateSimulator::parseEvent(line, &error);
+        ASSERT_TRUE(event) << line;
+        simulator.replay(*event);
+    }
+    auto report = simulator.finish(2000 * kMsNs);
+    std::vector<std::pair<int64_t, int32_t>> timeline = {{0, 120}, {500 * kMsNs, 60}};
+    EXPECT_EQ(report.timeline, timeline);
+    EXPECT_EQ(report.dwellHeldCnt, 1u);
+}
+
+TEST(OperationRateControllerTest, QueryFollowsTheHeldRate) {
+    auto config = getConfig();
+    config.dwell.highestRateMinNs = 500 * kMsNs;
+    config.hasHistogram = true;
+    OperationRateController controller(config);
+    controller.setPeakRefreshRate(60);
+    controller.setRefreshRate(60);
+
+    // the dbv delta would stop the query for the switch to 60 if it was not held
+    ASSERT_TRUE(controller.setDbv(500, 100 * kMsNs));
+    auto update = controller.update(Condition::SET_DBV, true, 100 * kMsNs);
+    EXPECT_EQ(update.heldRate, 60);
+    EXPECT_FALSE(update.decision.stopQuery);
+    EXPECT_TRUE(update.decision.startQuery);
+
+    update = controller.update(Condition::DWELL_EXPIRED, true, 500 * kMsNs);
+    EXPECT_EQ(update.heldRate, 0);
+    EXPECT_EQ(controller.getTargetRate(), 60);
+    EXPECT_FALSE(update.decision.startQuery);
+
+    // without a dwell time the same dbv change switches and stops the query
+    config.dwell.highestRateMinNs = 0;
+    OperationRateController direct(config);
+    direct.setPeakRefreshRate(60);
+    direct.setRefreshRate(60);
+    ASSERT_TRUE(direct.setDbv(500, 100 * kMsNs));
+    update = direct.update(Condition::SET_DBV, true, 100 * kMsNs);
+    EXPECT_TRUE(update.decision.targetChanged);
+    EXPECT_TRUE(update.decision.stopQuery);
+    EXPECT_FALSE(update.decision.startQuery);
+}
+
+TEST(OperationRateControllerTest, SimulatorStartsFromTheControllerState) {
+    OperationRateSimulator::Config_t config = {};
+    auto controllerConfig = getConfig();
+    config.policy = controllerConfig.policy;
+    config.dbvPredictor = controllerConfig.dbvPredictor;
+    config.vendorPeakRefreshRate = 60;
+    config.configSettingEnabled = true;
+    OperationRateSimulator simulator(config);
+    EXPECT_EQ(simulator.getOperationRate(), 120);
+
+    bool error;
+    for (const char* line : {"10 config 60", "20 dbv 500", "30 power off", "40 power doze"}) {
+        auto event = OperationRateSimulator::parseEvent(line, &error);
+        ASSERT_TRUE(event) << line;
+        simulator.replay(*event);
+    }
+    auto report = simulator.finish(50 * kMsNs);
+    std::vector<std::pair<int64_t, int32_t>> timeline = {
+            {0, 120}, {20 * kMsNs, 60}, {30 * kMsNs, 0}, {40 * kMsNs, 30}};
+    EXPECT_EQ(report.timeline, timeline);
+    EXPECT_EQ(report.switchCnt, 1u);
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <optional>
+
+#include "OperationRatePolicy.h"
+
+using namespace zumapro;
+
+namespace {
+
+using Condition = OperationRatePolicy::Condition;
+using PowerState = OperationRatePolicy::PowerState;
+
+// hwc2_power_mode_t values, the header is not available to host builds
+enum PowerMode : int32_t {
+    POWER_MODE_OFF = 0,
+    POWER_MODE_DOZE = 1,
+    POWER_MODE_ON = 2,
+    POWER_MODE_DOZE_SUSPEND = 3,
+};
+
+constexpr int32_t kLowPowerOperationRate = 30;
+constexpr int32_t kBrightnessDeltaThreshold = 10;
+
+/*
+ * OperationRateManager::updateOperationRateLocked() before the decision moved into
+ * OperationRatePolicy, with the logs removed and the histogram worker reduced to counters.
+ */
+struct LegacyOperationRateManager {
+    int32_t hsRate;
+    int32_t nsRate;
+    int32_t targetRate;
+    int32_t nsMinDbv;
+    int32_t peakRefreshRate;
+    int32_t refreshRate;
+    int32_t lastDbv;
+    int32_t dbv;
+    int32_t hsSwitchMinDbv;
+    std::optional<int32_t> powerMode;
+    bool lowBatteryMode;
+    bool hasHistogram;
+    bool configSettingEnabled;
+    uint32_t stopQueryCnt = 0;
+    uint32_t startQueryCnt = 0;
+
+    int32_t getTargetOperationRate() const {
+        if (powerMode == POWER_MODE_DOZE || powerMode == POWER_MODE_DOZE_SUSPEND) {
+            return kLowPowerOperationRate;
+        }
+        return targetRate;
+    }
+
+    void update(Condition cond) {
+        int32_t dbv = (cond == Condition::SET_DBV) ? this->dbv : lastDbv;
+        int32_t desiredOpRate = hsRate;
+        bool isSteadyLowRefreshRate =
+                (peakRefreshRate && peakRefreshRate <= nsRate) || lowBatteryMode;
+        bool isDbvInBlockingZone = lowBatteryMode ? (dbv < nsMinDbv) : (dbv < hsSwitchMinDbv);
+        int32_t effectiveOpRate = 0;
+
+        if (isSteadyLowRefreshRate && refreshRate <= nsRate) desiredOpRate = nsRate;
+        if (isDbvInBlockingZone) desiredOpRate = hsRate;
+
+        if (powerMode == POWER_MODE_DOZE || powerMode == POWER_MODE_DOZE_SUSPEND) {
+            targetRate = kLowPowerOperationRate;
+            desiredOpRate = targetRate;
+            effectiveOpRate = desiredOpRate;
+        } else if (powerMode != POWER_MODE_ON) {
+            if (hasHistogram) stopQueryCnt++;
+            return;
+        }
+
+        if (cond == Condition::SET_CONFIG) {
+            if (refreshRate <= hsRate) {
+                if (!hasHistogram) {
+                    if (refreshRate > nsRate) effectiveOpRate = hsRate;
+                } else {
+                    if (refreshRate == targetRate && !isDbvInBlockingZone) stopQueryCnt++;
+                    if (!isDbvInBlockingZone) {
+                        if (lowBatteryMode && (!hsSwitchMinDbv || dbv < hsSwitchMinDbv)) {
+                            desiredOpRate = refreshRate;
+                        } else if (refreshRate > nsRate) {
+                            effectiveOpRate = hsRate;
+                        }
+                    }
+                }
+            }
+        } else if (cond == Condition::PANEL_SET_POWER) {
+            if (powerMode == POWER_MODE_ON) targetRate = getTargetOperationRate();
+            effectiveOpRate = desiredOpRate;
+        } else if (cond == Condition::SET_DBV) {
+            int32_t delta = abs(dbv - lastDbv);
+            if (!hasHistogram) {
+                if (desiredOpRate == hsRate || delta > kBrightnessDeltaThreshold) {
+                    effectiveOpRate = desiredOpRate;
+                }
+            } else if (delta > kBrightnessDeltaThreshold) {
+                effectiveOpRate = desiredOpRate;
+                stopQueryCnt++;
+            }
+            lastDbv = dbv;
+            if (!(effectiveOpRate > kLowPowerOperationRate && effectiveOpRate != targetRate)) {
+                if (!hasHistogram || (desiredOpRate == nsRate && isDbvInBlockingZone)) return;
+            }
+        } else if (cond == Condition::HISTOGRAM_DELTA) {
+            effectiveOpRate = desiredOpRate;
+        }
+
+        if (!configSettingEnabled && effectiveOpRate == nsRate) {
+            return;
+        } else if (effectiveOpRate > kLowPowerOperationRate && effectiveOpRate != targetRate) {
+            targetRate = effectiveOpRate;
+        }
+        if (hasHistogram && targetRate != desiredOpRate) startQueryCnt++;
+    }
+};
+
+PowerState toPowerState(std::optional<int32_t> powerMode) {
+    if (powerMode == POWER_MODE_ON) return PowerState::ON;
+    if (powerMode == POWER_MODE_DOZE || powerMode == POWER_MODE_DOZE_SUSPEND) {
+        return PowerState::LP;
+    }
+    return PowerState::OFF;
+}
+
+} // namespace
+
+/*
+ * Every combination of power mode, refresh and peak rates, target, dbv, battery and
+ * blocking zone configuration for the events of the legacy code, applied the way
+ * updateOperationRateLocked() applies a decision without a dwell filter.
+ */
+TEST(OperationRatePolicyTest, MatchesLegacyDecisions) {
+    const std::optional<int32_t> powerModes[] = {std::nullopt, POWER_MODE_OFF, POWER_MODE_DOZE,
+                                                 POWER_MODE_DOZE_SUSPEND, POWER_MODE_ON};
+    const Condition conds[] = {Condition::PANEL_SET_POWER, Condition::SET_CONFIG,
+                               Condition::SET_DBV, Condition::HISTOGRAM_DELTA};
+    const int32_t refreshRates[] = {0, 30, 60, 90, 120, 144};
+    const int32_t peakRefreshRates[] = {0, 60, 90, 120};
+    const int32_t targetRates[] = {30, 60, 120};
+    const int32_t dbvs[] = {0, 5, 50, 100, 200, 1000};
+    const int32_t minDbvs[] = {0, 100};
+    constexpr int32_t kHsRate = 120;
+
+    uint64_t caseCnt = 0, mismatchCnt = 0;
+    // clang-format off
+    for (int32_t nsRate : {30, 60})
+    for (Condition cond : conds)
+    for (auto powerMode : powerModes)
+    for (int32_t refreshRate : refreshRates)
+    for (int32_t peakRefreshRate : peakRefreshRates)
+    for (int32_t targetRate : targetRates)
+    for (int32_t dbv : dbvs)
+    for (int32_t lastDbv : dbvs)
+    for (int32_t nsMinDbv : minDbvs)
+    for (int32_t hsSwitchMinDbv : minDbvs)
+    for (bool lowBatteryMode : {false, true})
+    for (bool hasHistogram : {false, true})
+    for (bool configSettingEnabled : {false, true}) {
+        // clang-format on
+        LegacyOperationRateManager legacy = {kHsRate, nsRate, targetRate, nsMinDbv,
+                                             peakRefreshRate, refreshRate, lastDbv, dbv,
+                                             hsSwitchMinDbv, powerMode, lowBatteryMode,
+                                             hasHistogram, configSettingEnabled};
+        legacy.update(cond);
+
+        OperationRatePolicy::Config_t config;
+        config.rates = {nsRate, kHsRate};
+        config.lowPowerRate = kLowPowerOperationRate;
+        config.nsMinDbv = nsMinDbv;
+        config.hsSwitchMinDbv = hsSwitchMinDbv;
+        config.brightnessDeltaUpThreshold = kBrightnessDeltaThreshold;
+        config.brightnessDeltaDownThreshold = kBrightnessDeltaThreshold;
+        OperationRatePolicy policy(std::move(config));
+
+        OperationRatePolicy::Input_t input = {};
+        input.cond = cond;
+        input.power = toPowerState(powerMode);
+        input.refreshRate = refreshRate;
+        input.peakRefreshRate = peakRefreshRate;
+        input.dbv = (cond == Condition::SET_DBV) ? dbv : lastDbv;
+        input.predictedDbv = input.dbv;
+        input.lastDbv = lastDbv;
+        input.targetRate = targetRate;
+        input.lowBatteryMode = lowBatteryMode;
+        input.hasHistogram = hasHistogram;
+        input.configSettingEnabled = configSettingEnabled;
+        auto decision = policy.evaluate(input);
+
+        bool powerOff = decision.outcome == OperationRatePolicy::Outcome::POWER_OFF;
+        bool applied = decision.outcome == OperationRatePolicy::Outcome::APPLIED;
+        int32_t newTargetRate = powerOff ? targetRate : decision.targetRate;
+        int32_t newLastDbv = (!powerOff && decision.updateLastDbv) ? input.dbv : lastDbv;
+        uint32_t stopQueryCnt = decision.stopQuery;
+        uint32_t startQueryCnt = decision.startQuery && applied;
+
+        caseCnt++;
+        bool match = newTargetRate == legacy.targetRate && newLastDbv == legacy.lastDbv &&
+                stopQueryCnt == legacy.stopQueryCnt && startQueryCnt == legacy.startQueryCnt;
+        if (!match && mismatchCnt++ < 5) {
+            ADD_FAILURE() << "cond " << static_cast<uint32_t>(cond) << " power "
+                          << powerMode.value_or(-1) << " refresh " << refreshRate << " peak "
+                          << peakRefreshRate << " target " << targetRate << " dbv " << dbv
+                          << " last " << lastDbv << " nsMin " << nsMinDbv << " hsMin "
+                          << hsSwitchMinDbv << " battery " << lowBatteryMode << " histogram "
+                          << hasHistogram << " enabled " << configSettingEnabled << " ns "
+                          << nsRate << ": target " << legacy.targetRate << "/" << newTargetRate
+                          << " last " << legacy.lastDbv << "/" << newLastDbv << " stop "
+                          << legacy.stopQueryCnt << "/" << stopQueryCnt << " start "
+                          << legacy.startQueryCnt << "/" << startQueryCnt;
+        }
+    }
+    EXPECT_EQ(mismatchCnt, 0u) << "of " << caseCnt << " cases";
+}
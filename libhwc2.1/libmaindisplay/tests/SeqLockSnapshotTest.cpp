@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SeqLockSnapshot.h"
+
+using namespace zumapro;
+
+namespace {
+
+// same layout as OperationRateManager::State_t, the trailing bool leaves a partial word
+struct State_t {
+    int32_t dbv;
+    int32_t refreshRate;
+    int32_t peakRefreshRate;
+    int32_t powerMode;
+    int32_t targetOperationRate;
+    bool lowBatteryMode;
+};
+
+State_t makeState(int32_t value) {
+    return {value, value + 1, value + 2, value + 3, value + 4, (value & 1) != 0};
+}
+
+bool isConsistent(const State_t& state) {
+    int32_t value = state.dbv;
+    return state.refreshRate == value + 1 && state.peakRefreshRate == value + 2 &&
+            state.powerMode == value + 3 && state.targetOperationRate == value + 4 &&
+            state.lowBatteryMode == ((value & 1) != 0);
+}
+
+/* OperationRateManager: hooks publish under mLock, getTargetOperationRate() reads lock free */
+class Manager {
+public:
+    void onHook(int32_t value) {
+        std::lock_guard<std::mutex> lock(mLock);
+        mValue = value;
+        publishStateLocked();
+    }
+    State_t getState(uint32_t* version) const { return mState.load(version); }
+
+    std::mutex mLock;
+
+private:
+    void publishStateLocked() { mState.store(makeState(mValue)); }
+
+    int32_t mValue = 0;
+    SeqLockSnapshot<State_t> mState{makeState(0)};
+};
+
+} // namespace
+
+TEST(SeqLockSnapshotTest, LoadReturnsTheLastStore) {
+    SeqLockSnapshot<State_t> snapshot;
+    uint32_t version;
+    snapshot.load(&version);
+    EXPECT_EQ(version, 1u);
+
+    snapshot.store(makeState(41));
+    State_t state = snapshot.load(&version);
+    EXPECT_TRUE(isConsistent(state));
+    EXPECT_EQ(state.dbv, 41);
+    EXPECT_EQ(version, 2u);
+}
+
+// run under TSan, the payload words are atomics so a torn read must only ever be a retry
+TEST(SeqLockSnapshotTest, ConcurrentReadersSeeWholeStores) {
+    constexpr int kWriterCnt = 2;
+    constexpr int kReaderCnt = 4;
+    constexpr int32_t kStoreCnt = 50000;
+
+    Manager manager;
+    std::atomic<bool> stop = false;
+    std::atomic<uint64_t> tornCnt = 0;
+    std::atomic<uint64_t> regressedCnt = 0;
+    std::atomic<uint64_t> readCnt = 0;
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < kReaderCnt; r++) {
+        readers.emplace_back([&] {
+            uint32_t lastVersion = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                uint32_t version;
+                State_t state = manager.getState(&version);
+                tornCnt += !isConsistent(state);
+                regressedCnt += version < lastVersion;
+                lastVersion = version;
+                readCnt++;
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int w = 0; w < kWriterCnt; w++) {
+        writers.emplace_back([&, w] {
+            for (int32_t i = 1; i <= kStoreCnt; i++) manager.onHook(i * kWriterCnt + w);
+        });
+    }
+    for (auto& writer : writers) writer.join();
+    stop = true;
+    for (auto& reader : readers) reader.join();
+
+    EXPECT_EQ(tornCnt, 0u);
+    EXPECT_EQ(regressedCnt, 0u);
+    EXPECT_GT(readCnt, 0u);
+    uint32_t version;
+    manager.getState(&version);
+    EXPECT_EQ(version, 1u + kWriterCnt * kStoreCnt);
+}
+
+TEST(SeqLockSnapshotTest, ReadersDoNotWaitForTheWriterLock) {
+    Manager manager;
+    manager.onHook(7);
+
+    std::lock_guard<std::mutex> lock(manager.mLock);
+    State_t state;
+    std::thread reader([&] { state = manager.getState(nullptr); });
+    reader.join();
+    EXPECT_EQ(state.dbv, 7);
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Scalar stand-in for the NEON intrinsics HistogramStats.cpp uses, so the vector path can be
+ * checked against the scalar one on x86 hosts. Only built with
+ * HISTOGRAM_STATS_NEON_EMULATION, see Android.bp.
+ */
+
+#ifndef _ARM_NEON_EMULATION_ZUMAPRO_H
+#define _ARM_NEON_EMULATION_ZUMAPRO_H
+
+#include <cstdint>
+
+template <typename T, int N>
+struct NeonVector {
+    T lane[N];
+};
+
+typedef NeonVector<uint16_t, 4> uint16x4_t;
+typedef NeonVector<uint16_t, 8> uint16x8_t;
+typedef NeonVector<uint32_t, 2> uint32x2_t;
+typedef NeonVector<uint32_t, 4> uint32x4_t;
+typedef NeonVector<uint64_t, 2> uint64x2_t;
+
+inline uint16x8_t vld1q_u16(const uint16_t* ptr) {
+    uint16x8_t r;
+    for (int i = 0; i < 8; i++) r.lane[i] = ptr[i];
+    return r;
+}
+
+inline uint16x8_t vdupq_n_u16(uint16_t value) {
+    uint16x8_t r;
+    for (auto& lane : r.lane) lane = value;
+    return r;
+}
+
+inline uint64x2_t vdupq_n_u64(uint64_t value) {
+    return {{value, value}};
+}
+
+inline uint16x8_t vaddq_u16(uint16x8_t a, uint16x8_t b) {
+    for (int i = 0; i < 8; i++) a.lane[i] += b.lane[i];
+    return a;
+}
+
+inline uint32_t vaddlvq_u16(uint16x8_t a) {
+    uint32_t sum = 0;
+    for (auto lane : a.lane) sum += lane;
+    return sum;
+}
+
+inline uint64_t vaddvq_u64(uint64x2_t a) {
+    return a.lane[0] + a.lane[1];
+}
+
+inline uint16x4_t vget_low_u16(uint16x8_t a) {
+    return {{a.lane[0], a.lane[1], a.lane[2], a.lane[3]}};
+}
+
+inline uint16x4_t vget_high_u16(uint16x8_t a) {
+    return {{a.lane[4], a.lane[5], a.lane[6], a.lane[7]}};
+}
+
+inline uint32x2_t vget_low_u32(uint32x4_t a) {
+    return {{a.lane[0], a.lane[1]}};
+}
+
+inline uint32x2_t vget_high_u32(uint32x4_t a) {
+    return {{a.lane[2], a.lane[3]}};
+}
+
+inline uint32x4_t vmovl_u16(uint16x4_t a) {
+    return {{a.lane[0], a.lane[1], a.lane[2], a.lane[3]}};
+}
+
+inline uint32x4_t vmovl_high_u16(uint16x8_t a) {
+    return vmovl_u16(vget_high_u16(a));
+}
+
+inline uint32x4_t vmull_u16(uint16x4_t a, uint16x4_t b) {
+    uint32x4_t r;
+    for (int i = 0; i < 4; i++) r.lane[i] = static_cast<uint32_t>(a.lane[i]) * b.lane[i];
+    return r;
+}
+
+inline uint32x4_t vmull_high_u16(uint16x8_t a, uint16x8_t b) {
+    return vmull_u16(vget_high_u16(a), vget_high_u16(b));
+}
+
+inline uint64x2_t vpadalq_u32(uint64x2_t a, uint32x4_t b) {
+    a.lane[0] += static_cast<uint64_t>(b.lane[0]) + b.lane[1];
+    a.lane[1] += static_cast<uint64_t>(b.lane[2]) + b.lane[3];
+    return a;
+}
+
+inline uint64x2_t vmlal_u32(uint64x2_t a, uint32x2_t b, uint32x2_t c) {
+    for (int i = 0; i < 2; i++) a.lane[i] += static_cast<uint64_t>(b.lane[i]) * c.lane[i];
+    return a;
+}
+
+inline uint64x2_t vmlal_high_u32(uint64x2_t a, uint32x4_t b, uint32x4_t c) {
+    return vmlal_u32(a, vget_high_u32(b), vget_high_u32(c));
+}
+
+#endif // _ARM_NEON_EMULATION_ZUMAPRO_H
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Replays an operation rate event trace on the host and prints the resulting operation
+ * rate timeline, the number of switches and the time spent in each rate.
+ *
+ *   zumapro_op_rate_sim --ns 60 --hs 120 --hist-delta-th 10 trace.txt
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "OperationRateSimulator.h"
+
+using namespace zumapro;
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "usage: %s [options] <trace|->\n"
+            "  --ns <hz> --hs <hz>       NS and HS operation rates (default 60, 120)\n"
+            "  --rates <hz,hz,...>       all operation rates, replaces --ns/--hs\n"
+            "  --ns-min-dbv <dbv>        vendor.primarydisplay.op.ns_min_dbv\n"
+            "  --hs-switch-min-dbv <dbv> vendor.primarydisplay.op.hs_switch_min_dbv\n"
+            "  --hist-delta-th <luma>    vendor.primarydisplay.op.hist_delta_th\n"
+            "  --peak <hz>               vendor.primarydisplay.op.peak_refresh_rate\n"
+            "  --dbv-delta-up-th <dbv>   vendor.primarydisplay.op.dbv_delta_up_th\n"
+            "  --dbv-delta-down-th <dbv> vendor.primarydisplay.op.dbv_delta_down_th\n"
+            "  --hs-min-dwell-ms <ms>    vendor.primarydisplay.op.hs_min_dwell_ms\n"
+            "  --ns-min-dwell-ms <ms>    vendor.primarydisplay.op.ns_min_dwell_ms\n"
+            "  --dbv-predict-ms <ms>     vendor.primarydisplay.op.dbv_predict_ms\n"
+            "  --no-config-setting       rate switching disabled by the display\n"
+            "trace lines: <time ms> <config|dbv|power|peak|battery|luma> <value>\n",
+            name);
+}
+
+int main(int argc, char** argv) {
+    OperationRateSimulator::Config_t config = {};
+    config.policy.rates = {60, 120};
+    config.policy.lowPowerRate = 30;
+    config.policy.brightnessDeltaUpThreshold = 10;
+    config.policy.brightnessDeltaDownThreshold = 10;
+    config.configSettingEnabled = true;
+    config.dbvPredictor.maxStepNs = 200 * 1000000LL;
+    const char* tracePath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                exit(1);
+            }
+            return argv[++i];
+        };
+        if (!strcmp(argv[i], "--ns")) {
+            config.policy.rates.front() = atoi(next());
+        } else if (!strcmp(argv[i], "--hs")) {
+            config.policy.rates.back() = atoi(next());
+        } else if (!strcmp(argv[i], "--rates")) {
+            config.policy.rates.clear();
+            std::stringstream list(next());
+            for (std::string rate; std::getline(list, rate, ',');) {
+                config.policy.rates.push_back(atoi(rate.c_str()));
+            }
+        } else if (!strcmp(argv[i], "--ns-min-dbv")) {
+            config.policy.nsMinDbv = atoi(next());
+        } else if (!strcmp(argv[i], "--hs-switch-min-dbv")) {
+            config.policy.hsSwitchMinDbv = atoi(next());
+        } else if (!strcmp(argv[i], "--hist-delta-th")) {
+            config.histogramDeltaThreshold = atof(next());
+        } else if (!strcmp(argv[i], "--peak")) {
+            config.vendorPeakRefreshRate = atoi(next());
+        } else if (!strcmp(argv[i], "--dbv-delta-up-th")) {
+            config.policy.brightnessDeltaUpThreshold = atoi(next());
+        } else if (!strcmp(argv[i], "--dbv-delta-down-th")) {
+            config.policy.brightnessDeltaDownThreshold = atoi(next());
+        } else if (!strcmp(argv[i], "--hs-min-dwell-ms")) {
+            config.dwell.highestRateMinNs = atoll(next()) * 1000000;
+        } else if (!strcmp(argv[i], "--ns-min-dwell-ms")) {
+            config.dwell.lowerRateMinNs = atoll(next()) * 1000000;
+        } else if (!strcmp(argv[i], "--dbv-predict-ms")) {
+            config.dbvPredictor.horizonNs = atoll(next()) * 1000000;
+        } else if (!strcmp(argv[i], "--no-config-setting")) {
+            config.configSettingEnabled = false;
+        } else if (!tracePath && (argv[i][0] != '-' || !strcmp(argv[i], "-"))) {
+            tracePath = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!tracePath || config.policy.rates.empty() ||
+        !std::is_sorted(config.policy.rates.begin(), config.policy.rates.end())) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream file;
+    if (strcmp(tracePath, "-")) {
+        file.open(tracePath);
+        if (!file) {
+            fprintf(stderr, "failed to open %s\n", tracePath);
+            return 1;
+        }
+    }
+    std::istream& trace = file.is_open() ? file : std::cin;
+
+    OperationRateSimulator simulator(config);
+    int64_t endNs = 0;
+    int lineNo = 0;
+    for (std::string line; std::getline(trace, line);) {
+        lineNo++;
+        bool error;
+        auto event = OperationRateSimulator::parseEvent(line, &error);
+        if (error) {
+            fprintf(stderr, "line %d: invalid event '%s'\n", lineNo, line.c_str());
+            return 1;
+        }
+        if (!event) continue;
+        if (event->timeNs < endNs) {
+            fprintf(stderr, "line %d: time goes backwards\n", lineNo);
+            return 1;
+        }
+        simulator.replay(*event);
+        endNs = event->timeNs;
+    }
+
+    const auto report = simulator.finish(endNs);
+    printf("# time_ms rate\n");
+    for (const auto& [timeNs, rate] : report.timeline) {
+        printf("%.3f %d\n", timeNs / 1e6, rate);
+    }
+    printf("# switches %u, held by dwell %u, held by hysteresis %u, duration %.3f s\n",
+           report.switchCnt, report.dwellHeldCnt, report.hysteresisHeldCnt,
+           report.durationNs / 1e9);
+    const auto& prediction = report.dbvPrediction;
+    if (config.dbvPredictor.horizonNs) {
+        printf("# dbv prediction: predicted %" PRIu64 ", hit %" PRIu64 ", false alarm %" PRIu64
+               ", missed %" PRIu64 ", avg lead %.1f ms\n",
+               prediction.predictedCnt, prediction.hitCnt, prediction.falseAlarmCnt,
+               prediction.missedCnt,
+               prediction.hitCnt ? prediction.totalLeadNs / 1e6 / prediction.hitCnt : 0.0);
+    }
+    for (const auto& [rate, timeNs] : report.timeInRateNs) {
+        printf("# %3d Hz: %.3f s (%.1f%%)\n", rate, timeNs / 1e9,
+               report.durationNs ? timeNs * 100.0 / report.durationNs : 0.0);
+    }
+    return 0;
+}
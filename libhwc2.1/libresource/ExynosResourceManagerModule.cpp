@@ -0,0 +1,504 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_GRAPHICS | ATRACE_TAG_HAL)
+
+#include <cutils/properties.h>
+
+#include <algorithm>
+#include <cinttypes>
+
+#include "ExynosResourceManagerModule.h"
+#include "ExynosDevice.h"
+#include "ExynosLayer.h"
+#include "TDMTrace.h"
+
+using namespace zumapro;
+
+ExynosResourceManagerModule::ExynosResourceManagerModule(ExynosDevice* device)
+      : zuma::ExynosResourceManagerModule(device) {
+    mAxiBalance = property_get_bool("vendor.display.tdm.axi_balance", false);
+    mBudgetPrecheck = property_get_bool("vendor.display.tdm.budget_precheck", false);
+    if (property_get_bool("vendor.display.tdm.optimal_assign", false)) {
+        int32_t budgetUs = property_get_int32("vendor.display.tdm.solver_budget_us",
+                                              kDefaultSolverBudgetUs);
+        mSolverBudget = std::chrono::microseconds(budgetUs);
+        ALOGI("%s: optimal OTF assignment enabled, budget %d us", __func__, budgetUs);
+    }
+}
+
+ExynosResourceManagerModule::~ExynosResourceManagerModule() {}
+
+void ExynosResourceManagerModule::initTDMChannels(ExynosDisplay* display,
+                                                  DisplayState_t& state) {
+    // the scaling limits of a DPP don't depend on the image size
+    exynos_image rgb = {};
+    rgb.format = HAL_PIXEL_FORMAT_RGBA_8888;
+    rgb.w = display->mXres;
+    rgb.h = display->mYres;
+    exynos_image yuv = rgb;
+    yuv.format = HAL_PIXEL_FORMAT_YCrCb_420_SP;
+
+    for (const auto& unit : available_otf_mpp_units) {
+        // bind by position, the last two fields are the DPU block and the AXI port
+        const auto& [physicalType, logicalType, name, physicalIndex, logicalIndex,
+                     preAssignInfo, blockId, axiId] = unit;
+        auto it = std::find_if(mOtfMPPs.begin(), mOtfMPPs.end(), [&](ExynosMPP* mpp) {
+            return mpp->mPhysicalType == physicalType && mpp->mPhysicalIndex == physicalIndex;
+        });
+        if (it == mOtfMPPs.end()) continue;
+
+        const ExynosMPP* mpp = *it;
+        TDMChannel_t channel = {name, physicalType, physicalIndex,
+                                static_cast<DPUblockId_t>(blockId),
+                                static_cast<AXIPortId_t>(axiId), physicalType == MPP_DPP_VGRFS,
+                                !!(mpp->mAttr & MPP_ATTR_ROT_90), 1, 1};
+        if (mpp->mAttr & MPP_ATTR_SCALE) {
+            // the tighter limit of the formats the channel reads
+            channel.maxUpscale = mpp->getMaxUpscale(rgb, rgb);
+            channel.maxDownscale = mpp->getMaxDownscale(*display, rgb, rgb);
+            if (channel.yuv) {
+                channel.maxUpscale = std::min(channel.maxUpscale, mpp->getMaxUpscale(yuv, yuv));
+                channel.maxDownscale = std::min(channel.maxDownscale,
+                                                mpp->getMaxDownscale(*display, yuv, yuv));
+            }
+            channel.maxUpscale = std::max(channel.maxUpscale, 1u);
+            channel.maxDownscale = std::max(channel.maxDownscale, 1u);
+        }
+        state.channels.push_back(channel);
+        state.channelMPPs.push_back(mpp);
+        if (state.channels.size() == TDMResourceModel::kMaxChannelCnt) break;
+    }
+
+    if (mSolverBudget) {
+        state.solver = std::make_unique<TDMAssignmentSolver>(state.channels, *mSolverBudget);
+    }
+}
+
+std::optional<uint32_t> ExynosResourceManagerModule::getChannelIndex(const DisplayState_t& state,
+                                                                     const ExynosMPP* mpp) const {
+    if (!mpp) return std::nullopt;
+    for (uint32_t i = 0; i < state.channelMPPs.size(); i++) {
+        if (state.channelMPPs[i] == mpp) return i;
+    }
+    return std::nullopt;
+}
+
+const TDMChannel_t* ExynosResourceManagerModule::getTDMChannel(const DisplayState_t& state,
+                                                               const ExynosMPP* mpp) const {
+    auto idx = getChannelIndex(state, mpp);
+    return idx ? &state.channels[*idx] : nullptr;
+}
+
+TDMLayerInfo_t ExynosResourceManagerModule::getLayerInfo(const exynos_image& src,
+                                                         const exynos_image& dst, bool wcg) {
+    TDMLayerInfo_t info;
+    info.srcWidth = src.w;
+    info.srcHeight = src.h;
+    info.dstWidth = dst.w;
+    info.dstHeight = dst.h;
+    info.yuv = isFormatYUV(src.format);
+    info.bit10 = isFormat10BitYUV420(src.format);
+    info.rgb16 = (src.format == HAL_PIXEL_FORMAT_RGB_565);
+    info.hasAlpha = formatHasAlphaChannel(src.format);
+    info.afbc = (src.compressionInfo.type == COMP_TYPE_AFBC);
+    info.sbwc = isFormatSBWC(src.format);
+    info.rot90 = (src.transform & HAL_TRANSFORM_ROT_90);
+    info.wcg = wcg;
+    return info;
+}
+
+bool ExynosResourceManagerModule::updateLayerInfos(ExynosDisplay* display, DisplayState_t& state,
+                                                   std::optional<uint64_t> fingerprint,
+                                                   const std::vector<uint8_t>& masks) {
+    // a layer needs WCG if any DPP stage processes it, index 0 is the client target
+    auto isWcg = [&](size_t idx) -> bool {
+        if (masks.size() == display->mLayers.size() + 1) return masks[idx] != 0;
+        return idx ? display->mLayers[idx - 1]->mNeedPreblending
+                   : display->mClientCompositionInfo.mNeedPreblending;
+    };
+
+    if (fingerprint && fingerprint == state.planFingerprint &&
+        state.layerSrcImgs.size() == display->mLayers.size()) {
+        // same layer stack, only the buffers are new
+        bool wcgChanged = false;
+        for (size_t i = 0; i < display->mLayers.size(); i++) {
+            state.layerSrcImgs[i].bufferHandle = display->mLayers[i]->mLayerBuffer;
+            wcgChanged |= (state.layerInfos[i].wcg != isWcg(i + 1));
+        }
+        wcgChanged |= (state.clientTargetInfo.wcg != isWcg(0));
+        if (!wcgChanged) return false;
+    }
+    state.planFingerprint = fingerprint;
+
+    bool changed = (state.layerInfos.size() != display->mLayers.size());
+    state.layerInfos.resize(display->mLayers.size());
+    state.layerSrcImgs.resize(display->mLayers.size());
+
+    for (size_t i = 0; i < display->mLayers.size(); i++) {
+        ExynosLayer* layer = display->mLayers[i];
+        exynos_image dst;
+        layer->setSrcExynosImage(&state.layerSrcImgs[i]);
+        layer->setDstExynosImage(&dst);
+        TDMLayerInfo_t info = getLayerInfo(state.layerSrcImgs[i], dst, isWcg(i + 1));
+        if (info != state.layerInfos[i]) {
+            state.layerInfos[i] = info;
+            changed = true;
+        }
+    }
+
+    TDMLayerInfo_t clientTarget = TDMTrace::getClientTarget(display->mXres, display->mYres);
+    clientTarget.wcg = isWcg(0);
+    if (clientTarget != state.clientTargetInfo) {
+        state.clientTargetInfo = clientTarget;
+        changed = true;
+    }
+    return changed;
+}
+
+TDMReservation_t ExynosResourceManagerModule::getReservation(const ExynosDisplay* display,
+                                                             const DisplayState_t& state) const {
+    TDMReservation_t reservation = {};
+    TDMBudgetLedger ledger;
+    ledger.reset(kConstraintRev, TDMBudgetLedger::Share::TOTAL);
+    auto charge = [&](const ExynosMPP* mpp, const TDMLayerInfo_t& info) {
+        auto idx = getChannelIndex(state, mpp);
+        if (!idx) return;
+        const TDMChannel_t& channel = state.channels[*idx];
+        const TDMDemand demand = TDMResourceModel::getDemand(info);
+        for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+            if (!demand[attr]) continue;
+            ledger.add(static_cast<tdm_attr_t>(attr), channel.blockId, channel.axiId,
+                       demand[attr]);
+        }
+        reservation.busyChannels |= 1u << *idx;
+    };
+
+    // the assignments of the last validate of the other displays
+    for (const ExynosDisplay* other : mDevice->mDisplays) {
+        if (other == display || !other->mPlugState) continue;
+        for (ExynosLayer* layer : other->mLayers) {
+            if (!layer->mOtfMPP) continue;
+            exynos_image src, dst;
+            layer->setSrcExynosImage(&src);
+            layer->setDstExynosImage(&dst);
+            charge(layer->mOtfMPP, getLayerInfo(src, dst, layer->mNeedPreblending));
+        }
+        const auto& clientTarget = other->mClientCompositionInfo;
+        if (clientTarget.mHasCompositionLayer && clientTarget.mOtfMPP) {
+            TDMLayerInfo_t info = TDMTrace::getClientTarget(other->mXres, other->mYres);
+            info.wcg = clientTarget.mNeedPreblending;
+            charge(clientTarget.mOtfMPP, info);
+        }
+    }
+    reservation.usage = ledger.snapshot();
+    return reservation;
+}
+
+void ExynosResourceManagerModule::prepareAssign(ExynosDisplay* display,
+                                                std::optional<uint64_t> fingerprint,
+                                                const std::vector<uint8_t>& dppFeatureMasks) {
+    if (display->mType != HWC_DISPLAY_PRIMARY) return;
+    DisplayState_t& state = mDisplayStates[display];
+    if (state.channels.empty()) initTDMChannels(display, state);
+    if (!state.solver && !mBudgetPrecheck && !mAxiBalance) return;
+
+    bool changed = updateLayerInfos(display, state, fingerprint, dppFeatureMasks);
+    if (changed) {
+        state.layerDemands.resize(state.layerInfos.size() + 1);
+        state.layerBytes.resize(state.layerInfos.size() + 1);
+        for (size_t i = 0; i < state.layerInfos.size(); i++) {
+            state.layerDemands[i] = TDMResourceModel::getDemand(state.layerInfos[i]);
+            state.layerBytes[i] = TDMResourceModel::getBytesPerFrame(state.layerInfos[i]);
+        }
+        state.layerDemands.back() = TDMResourceModel::getDemand(state.clientTargetInfo);
+        state.layerBytes.back() = TDMResourceModel::getBytesPerFrame(state.clientTargetInfo);
+    }
+
+    // the TOTAL budget less what the other displays hold, not the share of the display
+    TDMReservation_t reservation = getReservation(display, state);
+    if (reservation != state.reservation) {
+        state.reservation = reservation;
+        changed = true;
+    }
+    if (changed && state.solver) updateAssignmentPlan(display, state);
+
+    // syncReservations() charges the MPPs as the base module assigns them
+    state.ledger.reset(kConstraintRev, TDMBudgetLedger::Share::TOTAL);
+    state.ledger.rollback(state.reservation.usage);
+    state.usage = {};
+    state.reservedMPPs.assign(state.layerDemands.size(), nullptr);
+}
+
+void ExynosResourceManagerModule::updateAssignmentPlan(ExynosDisplay* display,
+                                                       DisplayState_t& state) {
+    ATRACE_CALL();
+    bool optimal = state.solver->solve(state.layerInfos, state.clientTargetInfo, kConstraintRev,
+                                       TDMBudgetLedger::Share::TOTAL, state.plan,
+                                       &state.reservation);
+    if (hwcCheckDebugMessages(eDebugTDM)) {
+        String8 log;
+        dumpPlan(state, log);
+        HDEBUGLOGD(eDebugTDM, "%s: display %u%s, reserved channels 0x%x%s", __func__,
+                   display->mDisplayId, optimal ? "" : " (timeout)",
+                   state.reservation.busyChannels, log.c_str());
+        HDEBUGLOGD(eDebugTDM, "%s",
+                   TDMTrace::formatStack(state.layerInfos, state.clientTargetInfo).c_str());
+    }
+}
+
+void ExynosResourceManagerModule::dumpPlan(const DisplayState_t& state, String8& log) const {
+    const auto& channels = state.solver->getChannels();
+    const auto& plan = state.plan;
+    for (size_t i = 0; i < plan.channels.size(); i++) {
+        int32_t channel = plan.channels[i];
+        log.appendFormat(" L%zu:%s", i,
+                         channel == TDMResourceModel::kClientComposition
+                                 ? "CLIENT"
+                                 : channels[channel].name.c_str());
+    }
+    log.appendFormat(" CT:%s, client layers %u, client pixels %" PRIu64,
+                     plan.clientTargetChannel == TDMResourceModel::kClientComposition
+                             ? "NONE"
+                             : channels[plan.clientTargetChannel].name.c_str(),
+                     plan.clientLayerCnt, plan.clientPixels);
+}
+
+void ExynosResourceManagerModule::dumpLedger(const DisplayState_t& state,
+                                             String8& result) const {
+    result.appendFormat("\tTDM ledger (budget precheck %s, reserved channels 0x%x):",
+                        mBudgetPrecheck ? "on" : "off", state.reservation.busyChannels);
+    for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+        for (uint32_t blockId = 0; blockId < DPU_BLOCK_CNT; blockId++) {
+            for (uint32_t axiId = 0; axiId < AXI_PORT_MAX_CNT; axiId++) {
+                auto tdmAttr = static_cast<tdm_attr_t>(attr);
+                auto dpuBlock = static_cast<DPUblockId_t>(blockId);
+                auto axiPort = static_cast<AXIPortId_t>(axiId);
+                int32_t usage = state.ledger.getUsage(tdmAttr, dpuBlock, axiPort);
+                if (!usage) continue;
+                auto limit = state.ledger.getLimit(tdmAttr, dpuBlock, axiPort);
+                result.appendFormat(" attr%u/%s/%s %d/%d", attr,
+                                    DPUBlocks.at(dpuBlock).c_str(), AXIPorts.at(axiPort).c_str(),
+                                    usage, limit.value_or(-1));
+            }
+        }
+    }
+    result.appendFormat("\n");
+}
+
+std::optional<size_t> ExynosResourceManagerModule::findLayer(const DisplayState_t& state,
+                                                             const exynos_image& src) const {
+    for (size_t i = 0; i < state.layerSrcImgs.size(); i++) {
+        const exynos_image& img = state.layerSrcImgs[i];
+        if (img.bufferHandle == src.bufferHandle && img.x == src.x && img.y == src.y &&
+            img.w == src.w && img.h == src.h && img.format == src.format &&
+            img.transform == src.transform)
+            return i;
+    }
+    return std::nullopt;
+}
+
+std::optional<AXIPortId_t> ExynosResourceManagerModule::getAxiPort(const DisplayState_t& state,
+                                                                  const ExynosMPP* mpp) const {
+    const auto* channel = getTDMChannel(state, mpp);
+    if (!channel) return std::nullopt;
+    return channel->axiId;
+}
+
+bool ExynosResourceManagerModule::syncReservations(ExynosDisplay* display,
+                                                   DisplayState_t& state) {
+    auto& reservedMPPs = state.reservedMPPs;
+    if (reservedMPPs.size() != display->mLayers.size() + 1) return false;
+
+    for (size_t i = 0; i < display->mLayers.size(); i++) {
+        const ExynosMPP* mpp = display->mLayers[i]->mOtfMPP;
+        if (mpp != reservedMPPs[i]) updateReservation(state, i, mpp);
+    }
+    const auto& clientTarget = display->mClientCompositionInfo;
+    const ExynosMPP* mpp = clientTarget.mHasCompositionLayer ? clientTarget.mOtfMPP : nullptr;
+    if (mpp != reservedMPPs.back()) updateReservation(state, reservedMPPs.size() - 1, mpp);
+    return true;
+}
+
+void ExynosResourceManagerModule::updateReservation(DisplayState_t& state, size_t idx,
+                                                    const ExynosMPP* mpp) {
+    const TDMDemand& demand = state.layerDemands[idx];
+    auto& usage = state.usage;
+    if (const auto* channel = getTDMChannel(state, state.reservedMPPs[idx])) {
+        for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+            if (!demand[attr]) continue;
+            state.ledger.release(static_cast<tdm_attr_t>(attr), channel->blockId,
+                                 channel->axiId, demand[attr]);
+        }
+        usage.afbcCnt[channel->blockId] -= demand[TDM_ATTR_AFBC];
+        usage.wcgCnt[channel->blockId] -= demand[TDM_ATTR_WCG];
+        usage.layerCnt[channel->axiId]--;
+        usage.bytes[channel->axiId] -= state.layerBytes[idx];
+    }
+    state.reservedMPPs[idx] = mpp;
+    if (const auto* channel = getTDMChannel(state, mpp)) {
+        // the base module decided on its own checks, count the layer even past the budget
+        for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+            if (!demand[attr]) continue;
+            state.ledger.add(static_cast<tdm_attr_t>(attr), channel->blockId, channel->axiId,
+                             demand[attr]);
+        }
+        usage.afbcCnt[channel->blockId] += demand[TDM_ATTR_AFBC];
+        usage.wcgCnt[channel->blockId] += demand[TDM_ATTR_WCG];
+        usage.layerCnt[channel->axiId]++;
+        usage.bytes[channel->axiId] += state.layerBytes[idx];
+    }
+}
+
+bool ExynosResourceManagerModule::fitsTDMBudget(DisplayState_t& state, const TDMChannel_t& channel,
+                                                const TDMDemand& demand) {
+    auto snapshot = state.ledger.snapshot();
+    bool fits = true;
+    for (uint32_t attr = 0; attr < TDM_ATTR_MAX && fits; attr++) {
+        if (!demand[attr]) continue;
+        fits = state.ledger.reserve(static_cast<tdm_attr_t>(attr), channel.blockId,
+                                    channel.axiId, demand[attr]);
+    }
+    state.ledger.rollback(snapshot);
+    return fits;
+}
+
+void ExynosResourceManagerModule::balanceAxiLoad(const DisplayState_t& state,
+                                                 ExynosMPPVector& otfMPPs,
+                                                 const TDMLayerInfo_t& layer) {
+    // the key mirrors the usage counts of ORDER_AFBC, ORDER_WCG and ORDER_AXI
+    const auto& usage = state.usage;
+    mCandidates.clear();
+    for (ExynosMPP* mpp : otfMPPs) {
+        const auto* channel = getTDMChannel(state, mpp);
+        if (!channel) {
+            mCandidates.push_back({mpp, UINT32_MAX, UINT64_MAX});
+            continue;
+        }
+        uint32_t baseKey = layer.afbc ? usage.afbcCnt[channel->blockId]
+                : layer.wcg           ? usage.wcgCnt[channel->blockId]
+                                      : usage.layerCnt[channel->axiId];
+        mCandidates.push_back({mpp, baseKey, usage.bytes[channel->axiId]});
+    }
+
+    // only reorder within the runs the base module left with the same key
+    for (auto first = mCandidates.begin(); first != mCandidates.end();) {
+        auto last = std::find_if(first, mCandidates.end(), [&](const Candidate_t& candidate) {
+            return candidate.baseKey != first->baseKey;
+        });
+        std::stable_sort(first, last, [](const Candidate_t& lhs, const Candidate_t& rhs) {
+            return lhs.axiBytes < rhs.axiBytes;
+        });
+        first = last;
+    }
+    for (size_t i = 0; i < otfMPPs.size(); i++) otfMPPs[i] = mCandidates[i].mpp;
+}
+
+std::array<uint64_t, AXI_PORT_MAX_CNT> ExynosResourceManagerModule::getAxiLoad(
+        ExynosDisplay* display) const {
+    std::array<uint64_t, AXI_PORT_MAX_CNT> load = {};
+    auto it = mDisplayStates.find(display);
+    if (it == mDisplayStates.end()) return load;
+    const DisplayState_t& state = it->second;
+
+    for (size_t i = 0; i < display->mLayers.size(); i++) {
+        ExynosLayer* layer = display->mLayers[i];
+        if (!layer->mOtfMPP) continue;
+        auto axiId = getAxiPort(state, layer->mOtfMPP);
+        if (!axiId) continue;
+
+        exynos_image src, dst;
+        layer->setSrcExynosImage(&src);
+        layer->setDstExynosImage(&dst);
+        load[*axiId] += TDMResourceModel::getBytesPerFrame(getLayerInfo(src, dst, false));
+    }
+
+    const auto& clientTarget = display->mClientCompositionInfo;
+    if (clientTarget.mHasCompositionLayer && clientTarget.mOtfMPP) {
+        if (auto axiId = getAxiPort(state, clientTarget.mOtfMPP)) {
+            TDMLayerInfo_t info = {};
+            info.srcWidth = info.dstWidth = display->mXres;
+            info.srcHeight = info.dstHeight = display->mYres;
+            load[*axiId] += TDMResourceModel::getBytesPerFrame(info);
+        }
+    }
+    return load;
+}
+
+void ExynosResourceManagerModule::dumpAxiLoad(ExynosDisplay* display, String8& result) const {
+    auto load = getAxiLoad(display);
+    int32_t refreshRate = display->getRefreshRate(display->mActiveConfig);
+
+    result.appendFormat("AXI port load (estimated, %d Hz, balance %s)\n", refreshRate,
+                        mAxiBalance ? "on" : "off");
+    for (uint32_t axiId = 0; axiId < AXI_PORT_MAX_CNT; axiId++) {
+        uint64_t bytesPerSec = load[axiId] * std::max(refreshRate, 0);
+        result.appendFormat("\t%s: %" PRIu64 " KB/frame, %" PRIu64 " MB/s\n",
+                            AXIPorts.at(static_cast<AXIPortId_t>(axiId)).c_str(),
+                            load[axiId] / 1024, bytesPerSec / (1024 * 1024));
+    }
+    auto it = mDisplayStates.find(display);
+    if (it == mDisplayStates.end()) return;
+    const DisplayState_t& state = it->second;
+    if (mBudgetPrecheck) dumpLedger(state, result);
+    if (state.solver) {
+        const auto& stats = state.solver->getStats();
+        result.appendFormat("\tsolver: solved %" PRIu64 ", improved %" PRIu64
+                            ", timeout %" PRIu64 " (budget %" PRId64 " ns)\n",
+                            stats.solveCnt, stats.improvedCnt, stats.timeoutCnt,
+                            static_cast<int64_t>(state.solver->getTimeBudget().count()));
+    }
+    // the channels the recorded stacks of tools/tdm_sim.cpp are replayed on
+    for (const auto& channel : state.channels) {
+        result.appendFormat("\t%s\n", TDMTrace::formatChannel(channel).c_str());
+    }
+}
+
+int32_t ExynosResourceManagerModule::otfMppReordering(ExynosDisplay* display,
+                                                      ExynosMPPVector& otfMPPs,
+                                                      struct exynos_image& src,
+                                                      struct exynos_image& dst) {
+    int32_t ret = zuma::ExynosResourceManagerModule::otfMppReordering(display, otfMPPs, src, dst);
+    if (display->mType != HWC_DISPLAY_PRIMARY) return ret;
+
+    auto stateIt = mDisplayStates.find(display);
+    if (stateIt == mDisplayStates.end()) return ret;
+    DisplayState_t& state = stateIt->second;
+    if (!syncReservations(display, state)) return ret;
+    auto idx = findLayer(state, src);
+    if (!idx) return ret;
+
+    if (mAxiBalance) balanceAxiLoad(state, otfMPPs, state.layerInfos[*idx]);
+
+    if (mBudgetPrecheck) {
+        // channels the layer doesn't fit on by the ledger go last
+        const TDMDemand& demand = state.layerDemands[*idx];
+        std::stable_partition(otfMPPs.begin(), otfMPPs.end(), [&](ExynosMPP* mpp) {
+            const auto* channel = getTDMChannel(state, mpp);
+            return !channel || fitsTDMBudget(state, *channel, demand);
+        });
+    }
+
+    if (!state.solver || *idx >= state.plan.channels.size()) return ret;
+    int32_t channel = state.plan.channels[*idx];
+    if (channel == TDMResourceModel::kClientComposition) return ret;
+
+    // try the planned channel first, the rest keeps the order of the base module
+    auto it = std::find(otfMPPs.begin(), otfMPPs.end(), state.channelMPPs[channel]);
+    if (it != otfMPPs.end()) std::rotate(otfMPPs.begin(), it, it + 1);
+
+    return ret;
+}
@@ -17,11 +17,117 @@
 #ifndef _EXYNOS_RESOURCE_MANAGER_MODULE_ZUMAPRO_H
 #define _EXYNOS_RESOURCE_MANAGER_MODULE_ZUMAPRO_H
 
+#include <unordered_map>
+
 #include "../../zuma/libhwc2.1/libresource/ExynosResourceManagerModule.h"
+#include "TDMAssignmentSolver.h"
 
 namespace zumapro {
 
-using ExynosResourceManagerModule = zuma::ExynosResourceManagerModule;
+class ExynosResourceManagerModule : public zuma::ExynosResourceManagerModule {
+public:
+    ExynosResourceManagerModule(ExynosDevice* device);
+    ~ExynosResourceManagerModule();
+
+    int32_t otfMppReordering(ExynosDisplay* display, ExynosMPPVector& otfMPPs,
+                             struct exynos_image& src, struct exynos_image& dst) override;
+
+    static TDMLayerInfo_t getLayerInfo(const exynos_image& src, const exynos_image& dst,
+                                       bool wcg);
+    /*
+     * estimated bytes per frame read through each AXI port by the assigned layers. It walks
+     * the layers for dumpsys, the assignment uses the load prepareAssign() tracks.
+     */
+    std::array<uint64_t, AXI_PORT_MAX_CNT> getAxiLoad(ExynosDisplay* display) const;
+    void dumpAxiLoad(ExynosDisplay* display, String8& result) const;
+    /*
+     * called by the display once per validate after the preblending decision, before the
+     * assignment. `fingerprint` is the layer stack fingerprint of the frame if known, and
+     * `dppFeatureMasks` holds the DPP features of the client target and the layers, empty if
+     * they are not resolved, see ExynosPrimaryDisplayModule::getDppFeatureMasks().
+     */
+    void prepareAssign(ExynosDisplay* display, std::optional<uint64_t> fingerprint,
+                       const std::vector<uint8_t>& dppFeatureMasks);
+
+private:
+    // usage the zuma base module orders the channels by, and the estimated AXI traffic
+    typedef struct AssignUsage {
+        std::array<uint32_t, DPU_BLOCK_CNT> afbcCnt;
+        std::array<uint32_t, DPU_BLOCK_CNT> wcgCnt;
+        std::array<uint32_t, AXI_PORT_MAX_CNT> layerCnt;
+        std::array<uint64_t, AXI_PORT_MAX_CNT> bytes;
+    } AssignUsage_t;
+
+    /* TDM state of one primary display, the displays share the OTF MPPs of the DPU */
+    typedef struct DisplayState {
+        std::vector<TDMChannel_t> channels;
+        std::vector<const ExynosMPP*> channelMPPs;
+        // created with the channels if the optimal assignment is enabled by property
+        std::unique_ptr<TDMAssignmentSolver> solver;
+        std::vector<TDMLayerInfo_t> layerInfos;
+        std::vector<exynos_image> layerSrcImgs;
+        TDMLayerInfo_t clientTargetInfo = {};
+        TDMResourceModel::Result_t plan;
+        // layer stack fingerprint the plan was made for
+        std::optional<uint64_t> planFingerprint;
+        // channels and usage of the other displays the plan and the ledger start from
+        TDMReservation_t reservation = {};
+        // TDM usage of the assignment in progress, the client target is the last entry
+        TDMBudgetLedger ledger;
+        AssignUsage_t usage = {};
+        std::vector<TDMDemand> layerDemands;
+        std::vector<uint64_t> layerBytes;
+        std::vector<const ExynosMPP*> reservedMPPs;
+    } DisplayState_t;
+
+    typedef struct Candidate {
+        ExynosMPP* mpp;
+        uint32_t baseKey;
+        uint64_t axiBytes;
+    } Candidate_t;
+
+    /* OTF MPPs in the order of available_otf_mpp_units as seen by the TDM model */
+    void initTDMChannels(ExynosDisplay* display, DisplayState_t& state);
+    std::optional<uint32_t> getChannelIndex(const DisplayState_t& state,
+                                            const ExynosMPP* mpp) const;
+    const TDMChannel_t* getTDMChannel(const DisplayState_t& state, const ExynosMPP* mpp) const;
+    /* return true if the TDM relevant properties of the layers changed */
+    bool updateLayerInfos(ExynosDisplay* display, DisplayState_t& state,
+                          std::optional<uint64_t> fingerprint,
+                          const std::vector<uint8_t>& dppFeatureMasks);
+    /* channels and TDM usage of the current assignments of the other displays */
+    TDMReservation_t getReservation(const ExynosDisplay* display,
+                                    const DisplayState_t& state) const;
+    void updateAssignmentPlan(ExynosDisplay* display, DisplayState_t& state);
+    void dumpPlan(const DisplayState_t& state, String8& log) const;
+    void dumpLedger(const DisplayState_t& state, String8& result) const;
+    std::optional<size_t> findLayer(const DisplayState_t& state, const exynos_image& src) const;
+    std::optional<AXIPortId_t> getAxiPort(const DisplayState_t& state,
+                                          const ExynosMPP* mpp) const;
+    /* follow the assignment of the base module in the ledger, false if the stack is unknown */
+    bool syncReservations(ExynosDisplay* display, DisplayState_t& state);
+    void updateReservation(DisplayState_t& state, size_t idx, const ExynosMPP* mpp);
+    /* trial reservation of the demand on the channel, the ledger is left unchanged */
+    bool fitsTDMBudget(DisplayState_t& state, const TDMChannel_t& channel,
+                       const TDMDemand& demand);
+    /* sort the channels the base module ranks the same by the traffic of their AXI port */
+    void balanceAxiLoad(const DisplayState_t& state, ExynosMPPVector& otfMPPs,
+                        const TDMLayerInfo_t& layer);
+
+    // zumapro DPU follows the B0 constraints
+    static constexpr ConstraintRev_t kConstraintRev = CONSTRAINT_B0;
+    static constexpr int32_t kDefaultSolverBudgetUs = 200;
+
+    // time budget of the solver if the optimal assignment is enabled by property
+    std::optional<std::chrono::microseconds> mSolverBudget;
+    // balance the estimated AXI port traffic when ordering the channels
+    bool mAxiBalance;
+    // try the channels the layer fits on by the ledger first
+    bool mBudgetPrecheck;
+    // created on the first validate of each primary display
+    std::unordered_map<const ExynosDisplay*, DisplayState_t> mDisplayStates;
+    std::vector<Candidate_t> mCandidates;
+};
 
 } // namespace zumapro
 
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TDMAssignmentSolver.h"
+
+#include <algorithm>
+
+using namespace zumapro;
+
+TDMAssignmentSolver::TDMAssignmentSolver(std::vector<TDMChannel_t> channels,
+                                         std::chrono::nanoseconds timeBudget)
+      : mTimeBudget(timeBudget),
+        mTimeout(false),
+        mStats(),
+        mModel(std::move(channels)),
+        mConstraintRev(CONSTRAINT_NONE),
+        mShare(TDMBudgetLedger::Share::TOTAL) {
+    // channels of the same type and limits on the same DPU block and AXI port are
+    // interchangeable
+    const auto& otfChannels = mModel.getChannels();
+    mChannelClasses.resize(otfChannels.size());
+    mYuvChannelCnt = 0;
+    mRotChannelCnt = 0;
+    for (uint32_t i = 0; i < otfChannels.size(); i++) {
+        const auto& channel = otfChannels[i];
+        if (channel.yuv) mYuvChannelCnt++;
+        if (channel.rot90) mRotChannelCnt++;
+        mChannelClasses[i] = i;
+        for (uint32_t j = 0; j < i; j++) {
+            const auto& other = otfChannels[j];
+            if (channel.physicalType == other.physicalType && channel.blockId == other.blockId &&
+                channel.axiId == other.axiId && channel.yuv == other.yuv &&
+                channel.rot90 == other.rot90 && channel.maxUpscale == other.maxUpscale &&
+                channel.maxDownscale == other.maxDownscale) {
+                mChannelClasses[i] = mChannelClasses[j];
+                break;
+            }
+        }
+    }
+    updateCapacity();
+}
+
+void TDMAssignmentSolver::updateCapacity() {
+    mModel.reset(mConstraintRev, mShare);
+    const auto& ledger = mModel.getLedger();
+    for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+        mCapacity[attr] = std::nullopt;
+        for (uint32_t blockId = 0; blockId < DPU_BLOCK_CNT; blockId++) {
+            for (uint32_t axiId = 0; axiId < AXI_PORT_MAX_CNT; axiId++) {
+                auto tdmAttr = static_cast<tdm_attr_t>(attr);
+                auto block = static_cast<DPUblockId_t>(blockId);
+                auto axi = static_cast<AXIPortId_t>(axiId);
+                auto limit = ledger.getLimit(tdmAttr, block, axi);
+                if (!limit) continue;
+                // a budget shared by both ports is counted once
+                if (axi != AXI0 && ledger.isAxiShared(tdmAttr, block, axi)) continue;
+                mCapacity[attr] = mCapacity[attr].value_or(0) + *limit;
+            }
+        }
+    }
+}
+
+bool TDMAssignmentSolver::isTimeout() {
+    if (mTimeout) return true;
+    if (++mStats.nodeCnt % kClockCheckInterval) return false;
+
+    mTimeout = std::chrono::steady_clock::now() >= mDeadline;
+    return mTimeout;
+}
+
+bool TDMAssignmentSolver::place(size_t depth) {
+    if (depth == mItems.size()) return true;
+    if (isTimeout()) return false;
+
+    auto& item = mItems[depth];
+    const auto& channels = mModel.getChannels();
+    uint32_t triedClasses = 0;
+    // try the channels of the less loaded AXI port first
+    AXIPortId_t firstPort = (mPortBytes[AXI1] < mPortBytes[AXI0]) ? AXI1 : AXI0;
+    for (uint32_t pass = 0; pass < AXI_PORT_MAX_CNT; pass++) {
+        for (uint32_t i = 0; i < channels.size(); i++) {
+            uint32_t classBit = 1u << mChannelClasses[i];
+            if ((channels[i].axiId == firstPort) != (pass == 0)) continue;
+            if ((triedClasses & classBit) || !mModel.isChannelFree(i) ||
+                !TDMResourceModel::isSupported(channels[i], *item.layer))
+                continue;
+            triedClasses |= classBit;
+
+            if (!mModel.tryAssign(i, item.demand)) continue;
+            item.channel = static_cast<int32_t>(i);
+            mPortBytes[channels[i].axiId] += item.bytes;
+            if (place(depth + 1)) return true;
+            mPortBytes[channels[i].axiId] -= item.bytes;
+            mModel.unassign(i, item.demand);
+            if (mTimeout) return false;
+        }
+    }
+    return false;
+}
+
+bool TDMAssignmentSolver::isFeasible(const std::vector<TDMLayerInfo_t>& layers,
+                                     const TDMLayerInfo_t& clientTarget,
+                                     const ClientRange_t& range) {
+    bool hasClient = range.first <= range.last;
+    size_t deviceCnt = layers.size() - (hasClient ? range.last - range.first + 1 : 0);
+    if (deviceCnt + (hasClient ? 1 : 0) > mModel.getChannels().size()) return false;
+
+    mItems.clear();
+    for (uint32_t i = 0; i < layers.size(); i++) {
+        if (hasClient && i >= range.first && i <= range.last) continue;
+        mItems.push_back({TDMResourceModel::getDemand(layers[i]),
+                          TDMResourceModel::getBytesPerFrame(layers[i]), &layers[i], i,
+                          TDMResourceModel::kClientComposition});
+    }
+    if (hasClient) {
+        mItems.push_back({TDMResourceModel::getDemand(clientTarget),
+                          TDMResourceModel::getBytesPerFrame(clientTarget), &clientTarget,
+                          kClientTargetItem, TDMResourceModel::kClientComposition});
+    }
+
+    // reject without searching when the total demand can't fit in the whole DPU
+    TDMDemand total{};
+    uint32_t yuvCnt = 0;
+    uint32_t rotCnt = 0;
+    for (const auto& item : mItems) {
+        for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) total[attr] += item.demand[attr];
+        yuvCnt += item.layer->yuv ? 1 : 0;
+        rotCnt += item.layer->rot90 ? 1 : 0;
+    }
+    if (yuvCnt > mYuvChannelCnt || rotCnt > mRotChannelCnt) return false;
+    for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+        if (mCapacity[attr] && total[attr] > *mCapacity[attr]) return false;
+    }
+
+    // place the most constrained layers first to fail early
+    std::stable_sort(mItems.begin(), mItems.end(), [](const Item_t& lhs, const Item_t& rhs) {
+        if (lhs.layer->yuv != rhs.layer->yuv) return lhs.layer->yuv;
+        if (lhs.layer->rot90 != rhs.layer->rot90) return lhs.layer->rot90;
+        return lhs.demand[TDM_ATTR_SRAM_AMOUNT] > rhs.demand[TDM_ATTR_SRAM_AMOUNT];
+    });
+
+    mModel.reset(mConstraintRev, mShare, mReservation ? &*mReservation : nullptr);
+    mPortBytes.fill(0);
+    return place(0);
+}
+
+bool TDMAssignmentSolver::solve(const std::vector<TDMLayerInfo_t>& layers,
+                                const TDMLayerInfo_t& clientTarget,
+                                ConstraintRev_t constraintRev, TDMBudgetLedger::Share share,
+                                TDMResourceModel::Result_t& result,
+                                const TDMReservation_t* reservation) {
+    mStats.solveCnt++;
+    if (mConstraintRev != constraintRev || mShare != share) {
+        mConstraintRev = constraintRev;
+        mShare = share;
+        updateCapacity();
+    }
+    mTimeout = false;
+    mDeadline = std::chrono::steady_clock::now() + mTimeBudget;
+
+    mReservation = reservation ? std::make_optional(*reservation) : std::nullopt;
+    mModel.reset(constraintRev, share, reservation);
+    mModel.assign(layers, clientTarget, result);
+    if (!result.clientLayerCnt) return true;
+
+    // the table order client range is contiguous too, only cheaper ranges can improve it
+    mRanges.clear();
+    // a layer no channel supports is client composited by every assignment
+    uint32_t unsupportedFirst = layers.size();
+    uint32_t unsupportedLast = 0;
+    const auto& channels = mModel.getChannels();
+    for (uint32_t i = 0; i < layers.size(); i++) {
+        if (std::any_of(channels.begin(), channels.end(), [&](const TDMChannel_t& channel) {
+                return TDMResourceModel::isSupported(channel, layers[i]);
+            }))
+            continue;
+        unsupportedFirst = std::min(unsupportedFirst, i);
+        unsupportedLast = std::max(unsupportedLast, i);
+    }
+    for (uint32_t first = 0; first < layers.size() && first <= unsupportedFirst; first++) {
+        uint64_t pixels = 0;
+        for (uint32_t last = first; last < layers.size(); last++) {
+            pixels += static_cast<uint64_t>(layers[last].dstWidth) * layers[last].dstHeight;
+            if (pixels >= result.clientPixels) break;
+            if (last >= unsupportedLast) mRanges.push_back({pixels, first, last});
+        }
+    }
+    std::sort(mRanges.begin(), mRanges.end(),
+              [](const ClientRange_t& lhs, const ClientRange_t& rhs) {
+                  return lhs.pixels < rhs.pixels;
+              });
+
+    // without any client layer first, then the cheapest client range first
+    ClientRange_t noClient = {0, 1, 0};
+    for (size_t i = (unsupportedFirst < layers.size()) ? 1 : 0; i <= mRanges.size(); i++) {
+        const auto& range = i ? mRanges[i - 1] : noClient;
+        if (!isFeasible(layers, clientTarget, range)) {
+            if (mTimeout) {
+                mStats.timeoutCnt++;
+                return false;
+            }
+            continue;
+        }
+
+        result.channels.assign(layers.size(), TDMResourceModel::kClientComposition);
+        result.clientTargetChannel = TDMResourceModel::kClientComposition;
+        for (const auto& item : mItems) {
+            if (item.index == kClientTargetItem) {
+                result.clientTargetChannel = item.channel;
+            } else {
+                result.channels[item.index] = item.channel;
+            }
+        }
+        bool hasClient = range.first <= range.last;
+        result.clientLayerCnt = hasClient ? range.last - range.first + 1 : 0;
+        result.clientPixels = range.pixels;
+        mStats.improvedCnt++;
+        return true;
+    }
+    return true;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TDM_ASSIGNMENT_SOLVER_ZUMAPRO_H
+#define _TDM_ASSIGNMENT_SOLVER_ZUMAPRO_H
+
+#include <chrono>
+#include <optional>
+
+#include "TDMResourceModel.h"
+
+namespace zumapro {
+
+/*
+ * Searches the OTF channel assignment that leaves the fewest pixels to client composition.
+ * Client composited layers have to be contiguous in z-order, so the candidates are the
+ * client layer ranges in increasing pixel cost, and the first range whose remaining layers
+ * plus the client target fit in the channels and the TDM budgets is the optimum. The
+ * table order assignment of TDMResourceModel, whose client range is contiguous as well, is
+ * the starting point, and it's kept if the time budget runs out before a cheaper assignment
+ * is found. Among the assignments with the
+ * same cost, the search prefers the AXI port with less estimated memory traffic.
+ */
+class TDMAssignmentSolver {
+public:
+    typedef struct Stats {
+        uint64_t solveCnt;
+        uint64_t improvedCnt;
+        uint64_t timeoutCnt;
+        uint64_t nodeCnt;
+    } Stats_t;
+
+    TDMAssignmentSolver(std::vector<TDMChannel_t> channels, std::chrono::nanoseconds timeBudget);
+
+    /*
+     * return true if result is proven optimal within the time budget. The channels and the
+     * usage of `reservation` are held by other displays and not available to the layers.
+     */
+    bool solve(const std::vector<TDMLayerInfo_t>& layers, const TDMLayerInfo_t& clientTarget,
+               ConstraintRev_t constraintRev, TDMBudgetLedger::Share share,
+               TDMResourceModel::Result_t& result,
+               const TDMReservation_t* reservation = nullptr);
+
+    const Stats_t& getStats() const { return mStats; }
+    std::chrono::nanoseconds getTimeBudget() const { return mTimeBudget; }
+    const std::vector<TDMChannel_t>& getChannels() const { return mModel.getChannels(); }
+
+private:
+    typedef struct ClientRange {
+        uint64_t pixels;
+        uint32_t first;
+        uint32_t last;
+    } ClientRange_t;
+
+    typedef struct Item {
+        TDMDemand demand;
+        uint64_t bytes;
+        const TDMLayerInfo_t* layer;
+        // index of the layer, or kClientTargetItem
+        uint32_t index;
+        int32_t channel;
+    } Item_t;
+
+    static constexpr uint32_t kClientTargetItem = UINT32_MAX;
+    // check the clock once per this many search nodes
+    static constexpr uint32_t kClockCheckInterval = 32;
+
+    bool isFeasible(const std::vector<TDMLayerInfo_t>& layers, const TDMLayerInfo_t& clientTarget,
+                    const ClientRange_t& range);
+    bool place(size_t depth);
+    bool isTimeout();
+    void updateCapacity();
+
+    const std::chrono::nanoseconds mTimeBudget;
+    std::chrono::steady_clock::time_point mDeadline;
+    bool mTimeout;
+    Stats_t mStats;
+
+    TDMResourceModel mModel;
+    ConstraintRev_t mConstraintRev;
+    TDMBudgetLedger::Share mShare;
+    // of the solve() in progress
+    std::optional<TDMReservation_t> mReservation;
+    std::vector<uint32_t> mChannelClasses;
+    uint32_t mYuvChannelCnt;
+    uint32_t mRotChannelCnt;
+    // total budget of each attribute over the DPU blocks, std::nullopt if not limited
+    std::array<std::optional<int32_t>, TDM_ATTR_MAX> mCapacity;
+    std::vector<ClientRange_t> mRanges;
+    std::vector<Item_t> mItems;
+    std::array<uint64_t, AXI_PORT_MAX_CNT> mPortBytes;
+};
+
+} // namespace zumapro
+
+#endif // _TDM_ASSIGNMENT_SOLVER_ZUMAPRO_H
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TDMBudgetLedger.h"
+
+using namespace zumapro;
+
+TDMBudgetLedger::TDMBudgetLedger() {
+    reset(CONSTRAINT_NONE, Share::TOTAL);
+}
+
+void TDMBudgetLedger::reset(ConstraintRev_t constraintRev, Share share) {
+    mConstraintRev = constraintRev;
+    mShare = share;
+    mUsage.fill(0);
+}
+
+std::optional<int32_t> TDMBudgetLedger::getLimit(tdm_attr_t attr, DPUblockId_t blockId,
+                                                 AXIPortId_t axiId) const {
+    const auto& slot = getSlot(attr, blockId, axiId);
+    if (!slot.valid) return std::nullopt;
+
+    switch (mShare) {
+        case Share::MAIN:
+            return slot.amounts.mainAmount;
+        case Share::MINOR:
+            return slot.amounts.minorAmount;
+        default:
+            return slot.amounts.total;
+    }
+}
+
+int32_t TDMBudgetLedger::getUsage(tdm_attr_t attr, DPUblockId_t blockId,
+                                  AXIPortId_t axiId) const {
+    // a budget shared by both AXI ports is consumed by the layers of either port
+    if (getSlot(attr, blockId, axiId).axiShared) {
+        return mUsage[getUsageIndex(attr, blockId, AXI0)] +
+                mUsage[getUsageIndex(attr, blockId, AXI1)];
+    }
+    return mUsage[getUsageIndex(attr, blockId, axiId)];
+}
+
+bool TDMBudgetLedger::canReserve(tdm_attr_t attr, DPUblockId_t blockId, AXIPortId_t axiId,
+                                 int32_t amount) const {
+    auto limit = getLimit(attr, blockId, axiId);
+    return !limit || getUsage(attr, blockId, axiId) + amount <= *limit;
+}
+
+bool TDMBudgetLedger::reserve(tdm_attr_t attr, DPUblockId_t blockId, AXIPortId_t axiId,
+                              int32_t amount) {
+    if (!canReserve(attr, blockId, axiId, amount)) return false;
+
+    add(attr, blockId, axiId, amount);
+    return true;
+}
+
+void TDMBudgetLedger::release(tdm_attr_t attr, DPUblockId_t blockId, AXIPortId_t axiId,
+                              int32_t amount) {
+    auto& usage = mUsage[getUsageIndex(attr, blockId, axiId)];
+    usage = (usage > amount) ? usage - amount : 0;
+}
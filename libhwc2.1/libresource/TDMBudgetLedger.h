@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TDM_BUDGET_LEDGER_ZUMAPRO_H
+#define _TDM_BUDGET_LEDGER_ZUMAPRO_H
+
+#include "TDMResourceTables.h"
+
+namespace zumapro {
+
+/*
+ * Running TDM resource usage of one display per DPU block and AXI port, checked against
+ * HWResourceSlots. Reserve and release are O(1) and a snapshot is a plain copy of the
+ * usage counters, so trial assignments can be reverted without recounting the layers.
+ */
+class TDMBudgetLedger {
+public:
+    enum class Share {
+        MAIN,  // HWResourceAmounts::mainAmount
+        MINOR, // HWResourceAmounts::minorAmount
+        TOTAL, // HWResourceAmounts::total
+    };
+
+    typedef std::array<int32_t, TDM_ATTR_MAX * DPU_BLOCK_CNT * AXI_PORT_MAX_CNT> Snapshot;
+
+    TDMBudgetLedger();
+
+    void reset(ConstraintRev_t constraintRev, Share share);
+
+    /* return the budget, or std::nullopt if the resource isn't limited */
+    std::optional<int32_t> getLimit(tdm_attr_t attr, DPUblockId_t blockId,
+                                    AXIPortId_t axiId) const;
+    /* return the usage counted against the budget of attr on blockId/axiId */
+    int32_t getUsage(tdm_attr_t attr, DPUblockId_t blockId, AXIPortId_t axiId) const;
+
+    bool canReserve(tdm_attr_t attr, DPUblockId_t blockId, AXIPortId_t axiId,
+                    int32_t amount) const;
+    /* add amount to the usage if it fits in the budget, return false otherwise */
+    bool reserve(tdm_attr_t attr, DPUblockId_t blockId, AXIPortId_t axiId, int32_t amount);
+    void release(tdm_attr_t attr, DPUblockId_t blockId, AXIPortId_t axiId, int32_t amount);
+    /* add amount to the usage without the budget check, for assignments made elsewhere */
+    void add(tdm_attr_t attr, DPUblockId_t blockId, AXIPortId_t axiId, int32_t amount) {
+        mUsage[getUsageIndex(attr, blockId, axiId)] += amount;
+    }
+
+    Snapshot snapshot() const { return mUsage; }
+    void rollback(const Snapshot& snapshot) { mUsage = snapshot; }
+
+    /* budget shared by both AXI ports of the DPU block */
+    bool isAxiShared(tdm_attr_t attr, DPUblockId_t blockId, AXIPortId_t axiId) const {
+        return getSlot(attr, blockId, axiId).axiShared;
+    }
+
+private:
+    static constexpr uint32_t getUsageIndex(tdm_attr_t attr, DPUblockId_t blockId,
+                                            AXIPortId_t axiId) {
+        return (attr * DPU_BLOCK_CNT + blockId) * AXI_PORT_MAX_CNT + axiId;
+    }
+    const HWResourceSlot_t& getSlot(tdm_attr_t attr, DPUblockId_t blockId,
+                                    AXIPortId_t axiId) const {
+        return HWResourceSlots[getHWResourceSlotIndex(attr, blockId, axiId, mConstraintRev)];
+    }
+
+    ConstraintRev_t mConstraintRev;
+    Share mShare;
+    Snapshot mUsage;
+};
+
+} // namespace zumapro
+
+#endif // _TDM_BUDGET_LEDGER_ZUMAPRO_H
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TDMResourceModel.h"
+
+#include <algorithm>
+
+using namespace zumapro;
+
+TDMResourceModel::TDMResourceModel(std::vector<TDMChannel_t> channels)
+      : mChannels(std::move(channels)), mBusyChannels(0) {
+    if (mChannels.size() > kMaxChannelCnt) mChannels.resize(kMaxChannelCnt);
+}
+
+TDMDemand TDMResourceModel::getDemand(const TDMLayerInfo_t& layer) {
+    TDMDemand demand{};
+    int32_t sram = 0;
+    forEachSramLookup(layer, [&](tdm_attr_t attr, uint32_t formatProperty,
+                                 lbWidthIndex_t widthIndex) {
+        sram += static_cast<int32_t>(getSramAmount(attr, formatProperty, widthIndex).value_or(0));
+    });
+    demand[TDM_ATTR_SRAM_AMOUNT] = sram;
+
+    if (layer.rot90) demand[TDM_ATTR_ROT_90] = 1;
+    if (layer.sbwc) demand[TDM_ATTR_SBWC] = 1;
+    if (layer.afbc) demand[TDM_ATTR_AFBC] = 1;
+    if (layer.yuv) demand[TDM_ATTR_ITP] = 1;
+    if (layer.needScaling()) demand[TDM_ATTR_SCALE] = 1;
+    if (layer.wcg) demand[TDM_ATTR_WCG] = 1;
+    return demand;
+}
+
+uint64_t TDMResourceModel::getBytesPerFrame(const TDMLayerInfo_t& layer) {
+    uint64_t bitsPerPixel;
+    if (layer.yuv) {
+        // 10 bit YUV is stored in 16 bit containers
+        bitsPerPixel = layer.bit10 ? 24 : 12;
+    } else {
+        bitsPerPixel = layer.rgb16 ? 16 : 32;
+    }
+    uint64_t bytes = static_cast<uint64_t>(layer.srcWidth) * layer.srcHeight * bitsPerPixel / 8;
+
+    // AFBC and SBWC save about half of the traffic on typical content
+    if (layer.afbc || layer.sbwc) bytes /= 2;
+    return bytes;
+}
+
+bool TDMResourceModel::isSupported(const TDMChannel_t& channel, const TDMLayerInfo_t& layer) {
+    if ((layer.yuv && !channel.yuv) || (layer.rot90 && !channel.rot90)) return false;
+
+    // the source is rotated before it's scaled to the destination
+    uint64_t srcWidth = layer.rot90 ? layer.srcHeight : layer.srcWidth;
+    uint64_t srcHeight = layer.rot90 ? layer.srcWidth : layer.srcHeight;
+    return layer.dstWidth <= srcWidth * channel.maxUpscale &&
+            layer.dstHeight <= srcHeight * channel.maxUpscale &&
+            srcWidth <= static_cast<uint64_t>(layer.dstWidth) * channel.maxDownscale &&
+            srcHeight <= static_cast<uint64_t>(layer.dstHeight) * channel.maxDownscale;
+}
+
+void TDMResourceModel::reset(ConstraintRev_t constraintRev, TDMBudgetLedger::Share share,
+                             const TDMReservation_t* reservation) {
+    mLedger.reset(constraintRev, share);
+    mBusyChannels = 0;
+    if (!reservation) return;
+    mLedger.rollback(reservation->usage);
+    mBusyChannels = reservation->busyChannels;
+}
+
+bool TDMResourceModel::tryAssign(uint32_t channelIdx, const TDMDemand& demand) {
+    if (!isChannelFree(channelIdx)) return false;
+
+    const auto& channel = mChannels[channelIdx];
+    auto snapshot = mLedger.snapshot();
+    for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+        if (!demand[attr]) continue;
+        if (!mLedger.reserve(static_cast<tdm_attr_t>(attr), channel.blockId, channel.axiId,
+                             demand[attr])) {
+            mLedger.rollback(snapshot);
+            return false;
+        }
+    }
+    mBusyChannels |= (1u << channelIdx);
+    return true;
+}
+
+void TDMResourceModel::unassign(uint32_t channelIdx, const TDMDemand& demand) {
+    const auto& channel = mChannels[channelIdx];
+    for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+        if (!demand[attr]) continue;
+        mLedger.release(static_cast<tdm_attr_t>(attr), channel.blockId, channel.axiId,
+                        demand[attr]);
+    }
+    mBusyChannels &= ~(1u << channelIdx);
+}
+
+int32_t TDMResourceModel::assignFirstAvailable(const TDMLayerInfo_t& layer) {
+    TDMDemand demand = getDemand(layer);
+    for (uint32_t i = 0; i < mChannels.size(); i++) {
+        if (isSupported(mChannels[i], layer) && tryAssign(i, demand)) {
+            return static_cast<int32_t>(i);
+        }
+    }
+    return kClientComposition;
+}
+
+void TDMResourceModel::assign(const std::vector<TDMLayerInfo_t>& layers,
+                              const TDMLayerInfo_t& clientTarget, Result_t& result) {
+    result.channels.resize(layers.size());
+    result.clientTargetChannel = kClientComposition;
+    result.clientLayerCnt = 0;
+    result.clientPixels = 0;
+
+    // widen the client range over every layer that falls back and assign again, until the
+    // layers outside of the range fit
+    const auto initialUsage = mLedger.snapshot();
+    const uint32_t initialBusyChannels = mBusyChannels;
+    size_t first = layers.size();
+    size_t last = 0;
+    for (bool widened = true; widened;) {
+        widened = false;
+        mLedger.rollback(initialUsage);
+        mBusyChannels = initialBusyChannels;
+        for (size_t i = 0; i < layers.size(); i++) {
+            if (first <= i && i <= last) {
+                result.channels[i] = kClientComposition;
+                continue;
+            }
+            result.channels[i] = assignFirstAvailable(layers[i]);
+            if (result.channels[i] != kClientComposition) continue;
+            first = std::min(first, i);
+            last = std::max(last, i);
+            widened = true;
+        }
+    }
+    if (first > last) return;
+
+    result.clientLayerCnt = last - first + 1;
+    for (size_t i = first; i <= last; i++) {
+        result.clientPixels += static_cast<uint64_t>(layers[i].dstWidth) * layers[i].dstHeight;
+    }
+
+    result.clientTargetChannel = assignFirstAvailable(clientTarget);
+    if (result.clientTargetChannel != kClientComposition) return;
+
+    // nothing can be shown without the client target, so every layer goes to the client
+    result.clientLayerCnt = layers.size();
+    result.clientPixels = 0;
+    for (size_t i = 0; i < layers.size(); i++) {
+        result.channels[i] = kClientComposition;
+        result.clientPixels += static_cast<uint64_t>(layers[i].dstWidth) * layers[i].dstHeight;
+    }
+}
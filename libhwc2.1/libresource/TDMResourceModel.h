@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TDM_RESOURCE_MODEL_ZUMAPRO_H
+#define _TDM_RESOURCE_MODEL_ZUMAPRO_H
+
+#include <string>
+#include <vector>
+
+#include "TDMBudgetLedger.h"
+
+namespace zumapro {
+
+/* Properties of a layer that decide its TDM resource demand */
+typedef struct TDMLayerInfo {
+    uint32_t srcWidth;
+    uint32_t srcHeight;
+    uint32_t dstWidth;
+    uint32_t dstHeight;
+    bool yuv;
+    bool bit10;
+    bool rgb16;
+    bool hasAlpha;
+    bool afbc;
+    bool sbwc;
+    bool rot90;
+    bool wcg;
+
+    bool operator==(const TDMLayerInfo& rhs) const {
+        return srcWidth == rhs.srcWidth && srcHeight == rhs.srcHeight &&
+                dstWidth == rhs.dstWidth && dstHeight == rhs.dstHeight && yuv == rhs.yuv &&
+                bit10 == rhs.bit10 && rgb16 == rhs.rgb16 && hasAlpha == rhs.hasAlpha &&
+                afbc == rhs.afbc && sbwc == rhs.sbwc && rot90 == rhs.rot90 && wcg == rhs.wcg;
+    }
+    bool operator!=(const TDMLayerInfo& rhs) const { return !(*this == rhs); }
+
+    bool needScaling() const {
+        return rot90 ? (srcWidth != dstHeight || srcHeight != dstWidth)
+                     : (srcWidth != dstWidth || srcHeight != dstHeight);
+    }
+} TDMLayerInfo_t;
+
+/* TDM_ATTR_SRAM_AMOUNT holds the SRAM amount, the other attributes count the usage */
+typedef std::array<int32_t, TDM_ATTR_MAX> TDMDemand;
+
+/* OTF channel as seen by the model, the resource manager fills it from its OTF MPPs */
+typedef struct TDMChannel {
+    std::string name;
+    uint32_t physicalType;
+    uint32_t physicalIndex;
+    DPUblockId_t blockId;
+    AXIPortId_t axiId;
+    // the channel reads YUV formats
+    bool yuv;
+    // MPP_ATTR_ROT_90 of the MPP
+    bool rot90;
+    // scaling ratio limits of the MPP, 1 if it doesn't scale
+    uint32_t maxUpscale;
+    uint32_t maxDownscale;
+} TDMChannel_t;
+
+/* OTF channels and TDM usage held by the other displays of the DPU */
+typedef struct TDMReservation {
+    // mask of the channel indices the other displays read from
+    uint32_t busyChannels;
+    TDMBudgetLedger::Snapshot usage;
+
+    bool operator==(const TDMReservation& rhs) const {
+        return busyChannels == rhs.busyChannels && usage == rhs.usage;
+    }
+    bool operator!=(const TDMReservation& rhs) const { return !(*this == rhs); }
+} TDMReservation_t;
+
+/*
+ * Device independent model of the OTF channel assignment of one display. It assigns
+ * layers to the given channels in order against the HWResourceSlots budgets, the same
+ * way the resource manager walks available_otf_mpp_units, and reports which layers would
+ * fall back to client composition. Like the resource manager, the client composited layers
+ * are widened to one contiguous range. It only depends on TDMResourceTables.h, so it also
+ * runs on the host, see tools/tdm_sim.cpp.
+ */
+class TDMResourceModel {
+public:
+    static constexpr int32_t kClientComposition = -1;
+
+    typedef struct Result {
+        // channel index of each layer, or kClientComposition
+        std::vector<int32_t> channels;
+        int32_t clientTargetChannel;
+        uint32_t clientLayerCnt;
+        uint64_t clientPixels;
+    } Result_t;
+
+    // busy channels are tracked in a uint32_t mask
+    static constexpr uint32_t kMaxChannelCnt = 32;
+
+    explicit TDMResourceModel(std::vector<TDMChannel_t> channels);
+
+    static TDMDemand getDemand(const TDMLayerInfo_t& layer);
+    /* fn(attr, formatProperty, widthIndex) for each SRAM amount getDemand() adds up */
+    template <typename Fn>
+    static void forEachSramLookup(const TDMLayerInfo_t& layer, Fn&& fn);
+    /* estimated bytes the DPP reads from memory for one frame of the layer */
+    static uint64_t getBytesPerFrame(const TDMLayerInfo_t& layer);
+    static bool isSupported(const TDMChannel_t& channel, const TDMLayerInfo_t& layer);
+    const std::vector<TDMChannel_t>& getChannels() const { return mChannels; }
+
+    /* start an assignment, with the channels and the usage of `reservation` taken if set */
+    void reset(ConstraintRev_t constraintRev, TDMBudgetLedger::Share share,
+               const TDMReservation_t* reservation = nullptr);
+    /* reserve the demand on the channel if the channel is free and the budget allows */
+    bool tryAssign(uint32_t channelIdx, const TDMDemand& demand);
+    void unassign(uint32_t channelIdx, const TDMDemand& demand);
+    bool isChannelFree(uint32_t channelIdx) const { return !(mBusyChannels & (1u << channelIdx)); }
+
+    /*
+     * assign the layers in z-order, then the client target if any layer falls back. The
+     * client layers are always contiguous in z-order, clientPixels is the pixel count of
+     * that range.
+     */
+    void assign(const std::vector<TDMLayerInfo_t>& layers, const TDMLayerInfo_t& clientTarget,
+                Result_t& result);
+
+    const TDMBudgetLedger& getLedger() const { return mLedger; }
+
+private:
+    int32_t assignFirstAvailable(const TDMLayerInfo_t& layer);
+
+    std::vector<TDMChannel_t> mChannels;
+    TDMBudgetLedger mLedger;
+    uint32_t mBusyChannels;
+};
+
+template <typename Fn>
+void TDMResourceModel::forEachSramLookup(const TDMLayerInfo_t& layer, Fn&& fn) {
+    uint32_t bpp = layer.bit10 ? BIT10 : BIT8;
+    if (layer.rot90) {
+        lbWidthIndex_t widthIndex = getLbWidthIndex(layer.srcHeight);
+        if (layer.sbwc) {
+            fn(TDM_ATTR_ROT_90, SBWC_Y, widthIndex);
+            fn(TDM_ATTR_ROT_90, SBWC_UV, widthIndex);
+        } else {
+            fn(TDM_ATTR_ROT_90, NON_SBWC_Y | bpp, widthIndex);
+            if (layer.yuv) fn(TDM_ATTR_ROT_90, NON_SBWC_UV | bpp, widthIndex);
+        }
+    } else {
+        lbWidthIndex_t widthIndex = getLbWidthIndex(layer.srcWidth);
+        if (layer.sbwc) {
+            fn(TDM_ATTR_SBWC, SBWC_Y, widthIndex);
+            fn(TDM_ATTR_SBWC, SBWC_UV, widthIndex);
+        }
+        if (layer.afbc) fn(TDM_ATTR_AFBC, layer.rgb16 ? RGB : (RGB | BIT8), widthIndex);
+    }
+    if (layer.yuv) fn(TDM_ATTR_ITP, bpp, LB_W_3073_INF);
+    if (layer.needScaling()) {
+        fn(TDM_ATTR_SCALE, layer.hasAlpha ? FORMAT_RGB_MASK : FORMAT_YUV_MASK, LB_W_3073_INF);
+    }
+}
+
+} // namespace zumapro
+
+#endif // _TDM_RESOURCE_MODEL_ZUMAPRO_H
@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _TDM_RESOURCE_TABLES_ZUMAPRO_H
+#define _TDM_RESOURCE_TABLES_ZUMAPRO_H
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+
+#include "TDMPlatform.h"
+
+/*
+ * TDM resource budgets and SRAM costs of the zumapro DPU as constexpr tables. Nothing here
+ * depends on the HWC runtime types, only on tdm_attr_t and the format property bits from
+ * TDMPlatform.h, so the tables and the TDM model built on them also compile on the host.
+ * ExynosHWCModule.h adds the keyed map views the resource manager searches.
+ */
+
+namespace zumapro {
+
+typedef enum DPUblockId {
+  DPUF0,
+  DPUF1,
+  DPU_BLOCK_CNT,
+} DPUblockId_t;
+
+typedef enum AXIPortId {
+  AXI0,
+  AXI1,
+  AXI_PORT_MAX_CNT,
+  AXI_DONT_CARE
+} AXIPortId_t;
+
+typedef enum ConstraintRev {
+  CONSTRAINT_NONE = 0, // don't care
+  CONSTRAINT_A0,
+  CONSTRAINT_B0,
+  CONSTRAINT_REV_CNT
+} ConstraintRev_t;
+
+typedef struct HWResourceAmounts {
+  int mainAmount;
+  int minorAmount;
+  int total;
+} HWResourceAmounts_t;
+
+/* Note :
+ * When External or Virtual display is connected,
+ * Primary amount = total - others */
+
+typedef struct HWResourceEntry {
+    tdm_attr_t attr;
+    DPUblockId_t DPUBlockNo;
+    AXIPortId_t axiId;
+    ConstraintRev_t constraintRev;
+    HWResourceAmounts_t amounts;
+} HWResourceEntry_t;
+
+/*
+ * AXI_DONT_CARE means the amount is shared by both AXI ports of the DPU block,
+ * CONSTRAINT_NONE means the amount doesn't depend on the constraint revision.
+ */
+constexpr HWResourceEntry_t HWResourceEntries[] = {
+        // SRAM
+        {TDM_ATTR_SRAM_AMOUNT, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE, {50, 30, 80}},
+        {TDM_ATTR_SRAM_AMOUNT, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE, {50, 30, 80}},
+        // SCALE
+        {TDM_ATTR_SCALE, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE, {2, 0, 2}},
+        {TDM_ATTR_SCALE, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE, {1, 1, 2}},
+        // SBWC
+        {TDM_ATTR_SBWC, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE, {2, 0, 2}},
+        {TDM_ATTR_SBWC, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE, {0, 2, 2}},
+        // AFBC
+        {TDM_ATTR_AFBC, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE, {3, 1, 4}},
+        {TDM_ATTR_AFBC, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE, {1, 3, 4}},
+        // ITP
+        {TDM_ATTR_ITP, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE, {3, 1, 4}},
+        {TDM_ATTR_ITP, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE, {1, 3, 4}},
+        // ROT_90
+        {TDM_ATTR_ROT_90, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE, {1, 1, 2}},
+        {TDM_ATTR_ROT_90, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE, {1, 1, 2}},
+        // WCG
+        {TDM_ATTR_WCG, DPUF0, AXI_DONT_CARE, CONSTRAINT_A0, {2, 0, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI_DONT_CARE, CONSTRAINT_A0, {0, 2, 2}},
+        {TDM_ATTR_WCG, DPUF0, AXI0, CONSTRAINT_B0, {2, 0, 2}},
+        {TDM_ATTR_WCG, DPUF0, AXI1, CONSTRAINT_B0, {2, 0, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI0, CONSTRAINT_B0, {0, 2, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI1, CONSTRAINT_B0, {0, 2, 2}},
+};
+
+typedef struct HWResourceSlot {
+    HWResourceAmounts_t amounts;
+    bool valid;
+    // the amount is shared by both AXI ports of the DPU block
+    bool axiShared;
+} HWResourceSlot_t;
+
+constexpr uint32_t kHWResourceSlotCnt =
+        TDM_ATTR_MAX * DPU_BLOCK_CNT * AXI_PORT_MAX_CNT * CONSTRAINT_REV_CNT;
+
+constexpr uint32_t getHWResourceSlotIndex(tdm_attr_t attr, DPUblockId_t blockId,
+                                          AXIPortId_t axiId, ConstraintRev_t constraintRev) {
+    return ((attr * DPU_BLOCK_CNT + blockId) * AXI_PORT_MAX_CNT + axiId) * CONSTRAINT_REV_CNT +
+            constraintRev;
+}
+
+constexpr bool isSameHWResourceAmounts(const HWResourceAmounts_t& lhs,
+                                       const HWResourceAmounts_t& rhs) {
+    return lhs.mainAmount == rhs.mainAmount && lhs.minorAmount == rhs.minorAmount &&
+            lhs.total == rhs.total;
+}
+
+/*
+ * Expands the AXI_DONT_CARE and CONSTRAINT_NONE wildcards of HWResourceEntries into
+ * every slot they cover. Returns an empty optional if two entries cover the same slot.
+ * A CONSTRAINT_NONE slot without its own entry gets the amounts of the revision
+ * specific slots when they all agree.
+ */
+constexpr std::optional<std::array<HWResourceSlot_t, kHWResourceSlotCnt>>
+buildHWResourceSlots() {
+    std::array<HWResourceSlot_t, kHWResourceSlotCnt> slots{};
+    for (const auto& entry : HWResourceEntries) {
+        for (uint32_t axi = AXI0; axi < AXI_PORT_MAX_CNT; axi++) {
+            if (entry.axiId != AXI_DONT_CARE && entry.axiId != axi) continue;
+            for (uint32_t rev = CONSTRAINT_NONE; rev < CONSTRAINT_REV_CNT; rev++) {
+                if (entry.constraintRev != CONSTRAINT_NONE && entry.constraintRev != rev)
+                    continue;
+                auto& slot = slots[getHWResourceSlotIndex(entry.attr, entry.DPUBlockNo,
+                                                          static_cast<AXIPortId_t>(axi),
+                                                          static_cast<ConstraintRev_t>(rev))];
+                if (slot.valid) return std::nullopt;
+                slot.amounts = entry.amounts;
+                slot.valid = true;
+                slot.axiShared = (entry.axiId == AXI_DONT_CARE);
+            }
+        }
+    }
+    for (uint32_t i = 0; i < kHWResourceSlotCnt; i += CONSTRAINT_REV_CNT) {
+        if (slots[i + CONSTRAINT_NONE].valid) continue;
+        bool agreed = true;
+        for (uint32_t rev = CONSTRAINT_NONE + 1; rev < CONSTRAINT_REV_CNT; rev++) {
+            agreed &= slots[i + rev].valid &&
+                    isSameHWResourceAmounts(slots[i + rev].amounts,
+                                            slots[i + CONSTRAINT_NONE + 1].amounts);
+        }
+        if (agreed) slots[i + CONSTRAINT_NONE] = slots[i + CONSTRAINT_NONE + 1];
+    }
+    return slots;
+}
+static_assert(buildHWResourceSlots().has_value(), "HWResourceEntries overlap each other");
+
+/* HWResourceEntries flattened to [tdm_attr_t][DPUblockId_t][AXIPortId_t][ConstraintRev_t] */
+constexpr std::array<HWResourceSlot_t, kHWResourceSlotCnt> HWResourceSlots =
+        *buildHWResourceSlots();
+
+/*
+ * Returns main/minor/total amounts with a single indexed load. Querying AXI_DONT_CARE
+ * for a per-port resource needs a second load and succeeds only if both ports have the
+ * same amounts, and CONSTRAINT_NONE succeeds only if every revision has the same amounts.
+ */
+constexpr std::optional<HWResourceAmounts_t> getHWResourceAmounts(tdm_attr_t attr,
+                                                                  DPUblockId_t blockId,
+                                                                  AXIPortId_t axiId,
+                                                                  ConstraintRev_t constraintRev) {
+    if (attr >= TDM_ATTR_MAX || blockId >= DPU_BLOCK_CNT || constraintRev >= CONSTRAINT_REV_CNT)
+        return std::nullopt;
+
+    bool anyAxi = (axiId == AXI_DONT_CARE);
+    if (!anyAxi && axiId >= AXI_PORT_MAX_CNT) return std::nullopt;
+
+    const auto& slot =
+            HWResourceSlots[getHWResourceSlotIndex(attr, blockId, anyAxi ? AXI0 : axiId,
+                                                   constraintRev)];
+    if (!slot.valid) return std::nullopt;
+    if (anyAxi && !slot.axiShared) {
+        const auto& other =
+                HWResourceSlots[getHWResourceSlotIndex(attr, blockId, AXI1, constraintRev)];
+        if (!other.valid || !isSameHWResourceAmounts(slot.amounts, other.amounts))
+            return std::nullopt;
+    }
+    return slot.amounts;
+}
+
+constexpr bool isHWResourceSlotsConsistent() {
+    for (const auto& entry : HWResourceEntries) {
+        for (uint32_t axi = AXI0; axi <= AXI_DONT_CARE; axi++) {
+            if (axi == AXI_PORT_MAX_CNT) continue;
+            if (entry.axiId != AXI_DONT_CARE && entry.axiId != axi) continue;
+            for (uint32_t rev = CONSTRAINT_NONE; rev < CONSTRAINT_REV_CNT; rev++) {
+                if (entry.constraintRev != CONSTRAINT_NONE && entry.constraintRev != rev)
+                    continue;
+                auto amounts = getHWResourceAmounts(entry.attr, entry.DPUBlockNo,
+                                                    static_cast<AXIPortId_t>(axi),
+                                                    static_cast<ConstraintRev_t>(rev));
+                if (!amounts || !isSameHWResourceAmounts(*amounts, entry.amounts)) return false;
+            }
+        }
+    }
+    return true;
+}
+static_assert(isHWResourceSlotsConsistent(), "HWResourceSlots differ from HWResourceEntries");
+static_assert(getHWResourceAmounts(TDM_ATTR_WCG, DPUF1, AXI_DONT_CARE, CONSTRAINT_B0)->total == 2);
+static_assert(getHWResourceAmounts(TDM_ATTR_WCG, DPUF0, AXI1, CONSTRAINT_NONE)->mainAmount == 2);
+static_assert(!getHWResourceAmounts(TDM_ATTR_WCG, DPUF0, AXI0, CONSTRAINT_REV_CNT));
+
+typedef enum lbWidthIndex {
+  LB_W_8_512,
+  LB_W_513_1024,
+  LB_W_1025_1536,
+  LB_W_1537_2048,
+  LB_W_2049_2304,
+  LB_W_2305_2560,
+  LB_W_2561_3072,
+  LB_W_3073_INF,
+  LB_W_INDEX_MAX,
+} lbWidthIndex_t;
+
+typedef struct lbWidthBoundary {
+  uint32_t widthDownto;
+  uint32_t widthUpto;
+} lbWidthBoundary_t;
+
+constexpr lbWidthBoundary_t lbWidthBoundaries[LB_W_INDEX_MAX] = {
+        {8, 512},     {513, 1024},  {1025, 1536}, {1537, 2048},
+        {2049, 2304}, {2305, 2560}, {2561, 3072}, {3073, 0xffff},
+};
+
+constexpr bool isLbWidthBoundaryContiguous() {
+    for (uint32_t i = 0; i < LB_W_INDEX_MAX; i++) {
+        if (lbWidthBoundaries[i].widthDownto > lbWidthBoundaries[i].widthUpto) return false;
+        if (i && lbWidthBoundaries[i].widthDownto != lbWidthBoundaries[i - 1].widthUpto + 1)
+            return false;
+    }
+    return true;
+}
+static_assert(isLbWidthBoundaryContiguous(),
+              "line buffer width buckets must be contiguous and non-overlapping");
+
+/*
+ * Branch-free classification: the index is the number of buckets whose upper bound is
+ * below the width. Widths under the first bucket fall into it and widths above the last
+ * upper bound fall into the last one.
+ */
+constexpr lbWidthIndex_t getLbWidthIndex(uint32_t width) {
+    uint32_t index = 0;
+    for (uint32_t i = 0; i < LB_W_INDEX_MAX - 1; i++) {
+        index += static_cast<uint32_t>(width > lbWidthBoundaries[i].widthUpto);
+    }
+    return static_cast<lbWidthIndex_t>(index);
+}
+
+static_assert(getLbWidthIndex(512) == LB_W_8_512);
+static_assert(getLbWidthIndex(513) == LB_W_513_1024);
+static_assert(getLbWidthIndex(2304) == LB_W_2049_2304);
+static_assert(getLbWidthIndex(2305) == LB_W_2305_2560);
+static_assert(getLbWidthIndex(3073) == LB_W_3073_INF);
+
+enum {
+  SBWC_Y = 0,
+  SBWC_UV,
+  NON_SBWC_Y,
+  NON_SBWC_UV,
+};
+
+/*
+ * SRAM amount of each (attribute, format property) row, indexed by lbWidthIndex_t.
+ * An amount of 0 means the combination is not defined for that width.
+ */
+typedef struct sramAmountRow {
+    tdm_attr_t attr;
+    uint32_t formatProperty;
+    uint32_t amount[LB_W_INDEX_MAX];
+} sramAmountRow_t;
+
+constexpr sramAmountRow_t sramAmountTable[] = {
+        /** Non rotation **/
+        /** BIT8 = 32bit format **/
+        {TDM_ATTR_AFBC, RGB | BIT8, {4, 4, 8, 8, 12, 12, 12, 16}},
+        /** 16bit format **/
+        {TDM_ATTR_AFBC, RGB, {2, 2, 4, 4, 6, 6, 6, 8}},
+
+        {TDM_ATTR_SBWC, SBWC_Y, {1, 1, 1, 1, 2, 2, 2, 2}},
+        {TDM_ATTR_SBWC, SBWC_UV, {2, 2, 2, 2, 2, 2, 2, 2}},
+
+        /** Rotation **/
+        {TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, {4, 8, 12, 16, 18, 18, 18, 18}},
+        {TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, {2, 4, 6, 8, 10, 10, 10, 10}},
+        {TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, {2, 4, 6, 8, 9, 9, 9, 9}},
+        {TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, {2, 2, 4, 4, 6, 6, 6, 6}},
+        {TDM_ATTR_ROT_90, SBWC_Y, {2, 4, 6, 8, 9, 9, 9, 9}},
+        {TDM_ATTR_ROT_90, SBWC_UV, {2, 2, 4, 4, 6, 6, 6, 6}},
+
+        {TDM_ATTR_ITP, BIT8, {0, 0, 0, 0, 0, 0, 0, 2}},
+        {TDM_ATTR_ITP, BIT10, {0, 0, 0, 0, 0, 0, 0, 2}},
+
+        /* It's meaning like ow,
+         * FORMAT_YUV_MASK == has no alpha, FORMAT_RGB_MASK == has alpha */
+        {TDM_ATTR_SCALE, FORMAT_YUV_MASK, {0, 0, 0, 0, 0, 0, 0, 12}},
+        {TDM_ATTR_SCALE, FORMAT_RGB_MASK, {0, 0, 0, 0, 0, 0, 0, 16}},
+};
+
+constexpr uint32_t kSramAmountRowCnt = std::size(sramAmountTable);
+static_assert(kSramAmountRowCnt < UINT8_MAX, "sramAmountIndex entries are uint8_t");
+
+/*
+ * The format properties are sparse bit masks, so they are folded into a dense slot with
+ * formatProperty % kSramFormatSlotCnt. The smallest slot count that keeps the rows of
+ * every attribute apart is searched at compile time.
+ */
+constexpr uint32_t kSramFormatSlotMax = 64;
+
+constexpr uint32_t findSramFormatSlotCnt() {
+    for (uint32_t slotCnt = 1; slotCnt <= kSramFormatSlotMax; slotCnt++) {
+        bool collided = false;
+        for (uint32_t i = 0; i < kSramAmountRowCnt && !collided; i++) {
+            for (uint32_t j = i + 1; j < kSramAmountRowCnt && !collided; j++) {
+                collided = sramAmountTable[i].attr == sramAmountTable[j].attr &&
+                        sramAmountTable[i].formatProperty % slotCnt ==
+                                sramAmountTable[j].formatProperty % slotCnt;
+            }
+        }
+        if (!collided) return slotCnt;
+    }
+    return 0;
+}
+
+constexpr uint32_t kSramFormatSlotCnt = findSramFormatSlotCnt();
+static_assert(kSramFormatSlotCnt, "format properties of sramAmountTable don't fold into slots");
+
+typedef std::array<std::array<uint8_t, kSramFormatSlotCnt>, TDM_ATTR_MAX> sramAmountIndex_t;
+
+constexpr sramAmountIndex_t buildSramAmountIndex() {
+    sramAmountIndex_t index{};
+    for (uint32_t i = 0; i < kSramAmountRowCnt; i++) {
+        const auto& row = sramAmountTable[i];
+        index[row.attr][row.formatProperty % kSramFormatSlotCnt] = static_cast<uint8_t>(i + 1);
+    }
+    return index;
+}
+
+/* 1 + row of sramAmountTable by [tdm_attr_t][format slot], 0 if there is no row */
+constexpr sramAmountIndex_t sramAmountIndex = buildSramAmountIndex();
+
+/*
+ * O(1) lookup: the attribute and the format slot select the row, the width index selects
+ * the column. The row's own format property is compared because a format without a row
+ * can share a slot with one that has a row.
+ */
+constexpr std::optional<uint32_t> getSramAmount(tdm_attr_t attr, uint32_t formatProperty,
+                                                lbWidthIndex_t widthIndex) {
+    if (attr >= TDM_ATTR_MAX || widthIndex >= LB_W_INDEX_MAX) return std::nullopt;
+
+    uint32_t row = sramAmountIndex[attr][formatProperty % kSramFormatSlotCnt];
+    if (!row || sramAmountTable[row - 1].formatProperty != formatProperty) return std::nullopt;
+
+    uint32_t amount = sramAmountTable[row - 1].amount[widthIndex];
+    return amount ? std::make_optional(amount) : std::nullopt;
+}
+
+static_assert(getSramAmount(TDM_ATTR_AFBC, RGB | BIT8, LB_W_3073_INF) == 16u);
+static_assert(getSramAmount(TDM_ATTR_ROT_90, SBWC_UV, LB_W_1025_1536) == 4u);
+static_assert(!getSramAmount(TDM_ATTR_SCALE, FORMAT_RGB_MASK, LB_W_8_512).has_value());
+static_assert(!getSramAmount(TDM_ATTR_WCG, RGB, LB_W_8_512).has_value());
+
+} // namespace zumapro
+
+#endif // _TDM_RESOURCE_TABLES_ZUMAPRO_H
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "TDMTrace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+using namespace zumapro;
+
+namespace {
+
+constexpr const char* kChannelTag = "tdm_channel";
+constexpr const char* kStackTag = "tdm_stack";
+
+typedef struct LayerFlag {
+    const char* name;
+    bool TDMLayerInfo_t::*field;
+} LayerFlag_t;
+
+constexpr LayerFlag_t kLayerFlags[] = {
+        {"yuv", &TDMLayerInfo_t::yuv},     {"bit10", &TDMLayerInfo_t::bit10},
+        {"rgb16", &TDMLayerInfo_t::rgb16}, {"alpha", &TDMLayerInfo_t::hasAlpha},
+        {"afbc", &TDMLayerInfo_t::afbc},   {"sbwc", &TDMLayerInfo_t::sbwc},
+        {"rot90", &TDMLayerInfo_t::rot90}, {"wcg", &TDMLayerInfo_t::wcg},
+};
+
+} // namespace
+
+std::string TDMTrace::formatChannel(const TDMChannel_t& channel) {
+    std::ostringstream out;
+    out << kChannelTag << " " << channel.name << " " << channel.physicalType << " "
+        << channel.physicalIndex << " " << channel.blockId << " " << channel.axiId << " "
+        << (channel.yuv ? "yuv" : "gfs") << " " << (channel.rot90 ? "rot90" : "norot") << " "
+        << channel.maxUpscale << " " << channel.maxDownscale;
+    return out.str();
+}
+
+std::string TDMTrace::formatStack(const std::vector<TDMLayerInfo_t>& layers,
+                                  const TDMLayerInfo_t& clientTarget) {
+    std::ostringstream out;
+    out << kStackTag << " " << clientTarget.dstWidth << "x" << clientTarget.dstHeight;
+    for (const auto& layer : layers) {
+        out << " " << layer.srcWidth << "x" << layer.srcHeight << ">" << layer.dstWidth << "x"
+            << layer.dstHeight;
+        char separator = ':';
+        for (const auto& flag : kLayerFlags) {
+            if (!(layer.*flag.field)) continue;
+            out << separator << flag.name;
+            separator = ',';
+        }
+    }
+    return out.str();
+}
+
+TDMLayerInfo_t TDMTrace::getClientTarget(uint32_t xres, uint32_t yres) {
+    TDMLayerInfo_t clientTarget = {};
+    clientTarget.srcWidth = clientTarget.dstWidth = xres;
+    clientTarget.srcHeight = clientTarget.dstHeight = yres;
+    clientTarget.hasAlpha = true;
+    return clientTarget;
+}
+
+bool TDMTrace::parseLayer(const std::string& token, TDMLayerInfo_t* layer) {
+    *layer = {};
+    int consumed = 0;
+    if (sscanf(token.c_str(), "%ux%u>%ux%u%n", &layer->srcWidth, &layer->srcHeight,
+               &layer->dstWidth, &layer->dstHeight, &consumed) != 4)
+        return false;
+    if (static_cast<size_t>(consumed) == token.size()) return true;
+    if (token[consumed] != ':') return false;
+
+    std::stringstream flags(token.substr(consumed + 1));
+    for (std::string name; std::getline(flags, name, ',');) {
+        bool found = false;
+        for (const auto& flag : kLayerFlags) {
+            if (name != flag.name) continue;
+            layer->*flag.field = true;
+            found = true;
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+std::optional<TDMTrace::Record_t> TDMTrace::parse(const std::string& line, bool* error) {
+    *error = false;
+    std::istringstream in(line);
+    std::string tag;
+    while (in >> tag && tag != kChannelTag && tag != kStackTag) {
+    }
+    if (!in) return std::nullopt;
+
+    Record_t record = {};
+    if (tag == kChannelTag) {
+        record.type = Record_t::Type::CHANNEL;
+        auto& channel = record.channel;
+        uint32_t blockId, axiId;
+        std::string type, rotation;
+        if (!(in >> channel.name >> channel.physicalType >> channel.physicalIndex >> blockId >>
+              axiId >> type >> rotation >> channel.maxUpscale >> channel.maxDownscale) ||
+            blockId >= DPU_BLOCK_CNT || axiId >= AXI_PORT_MAX_CNT ||
+            (type != "gfs" && type != "yuv") || (rotation != "rot90" && rotation != "norot") ||
+            !channel.maxUpscale || !channel.maxDownscale) {
+            *error = true;
+            return std::nullopt;
+        }
+        channel.blockId = static_cast<DPUblockId_t>(blockId);
+        channel.axiId = static_cast<AXIPortId_t>(axiId);
+        channel.yuv = (type == "yuv");
+        channel.rot90 = (rotation == "rot90");
+        return record;
+    }
+
+    record.type = Record_t::Type::STACK;
+    std::string token;
+    uint32_t xres, yres;
+    if (!(in >> token) || sscanf(token.c_str(), "%ux%u", &xres, &yres) != 2) {
+        *error = true;
+        return std::nullopt;
+    }
+    record.clientTarget = getClientTarget(xres, yres);
+    while (in >> token) {
+        TDMLayerInfo_t layer;
+        if (!parseLayer(token, &layer)) {
+            *error = true;
+            return std::nullopt;
+        }
+        record.layers.push_back(layer);
+    }
+    return record;
+}
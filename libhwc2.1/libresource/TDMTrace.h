@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _TDM_TRACE_ZUMAPRO_H
+#define _TDM_TRACE_ZUMAPRO_H
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "TDMResourceModel.h"
+
+namespace zumapro {
+
+/*
+ * Text form of the OTF channels and the layer stacks the TDM model works on. The resource
+ * manager prints them in dumpsys and with eDebugTDM, and tools/tdm_sim.cpp replays them.
+ *
+ *   tdm_channel <name> <physical type> <physical index> <DPU block> <AXI port> <gfs|yuv>
+ *               <rot90|norot> <max upscale> <max downscale>
+ *   tdm_stack <xres>x<yres> <src w>x<src h>><dst w>x<dst h>[:<flag>,...] ...
+ *
+ * Layer flags are yuv, bit10, rgb16, alpha, afbc, sbwc, rot90 and wcg. The client target of
+ * a stack is a full screen RGBA buffer of the display size.
+ */
+class TDMTrace {
+public:
+    typedef struct Record {
+        enum class Type { CHANNEL, STACK } type;
+        TDMChannel_t channel;
+        std::vector<TDMLayerInfo_t> layers;
+        TDMLayerInfo_t clientTarget;
+    } Record_t;
+
+    static std::string formatChannel(const TDMChannel_t& channel);
+    static std::string formatStack(const std::vector<TDMLayerInfo_t>& layers,
+                                   const TDMLayerInfo_t& clientTarget);
+    static TDMLayerInfo_t getClientTarget(uint32_t xres, uint32_t yres);
+
+    /*
+     * Text before the tdm_channel or tdm_stack tag is skipped, so logcat lines can be
+     * replayed as they are. Lines without a tag return std::nullopt without an error.
+     */
+    static std::optional<Record_t> parse(const std::string& line, bool* error);
+
+private:
+    static bool parseLayer(const std::string& token, TDMLayerInfo_t* layer);
+};
+
+} // namespace zumapro
+
+#endif // _TDM_TRACE_ZUMAPRO_H
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _TDM_PLATFORM_HOST_ZUMAPRO_H
+#define _TDM_PLATFORM_HOST_ZUMAPRO_H
+
+/*
+ * Host stand-in for libhwc2.1/TDMPlatform.h. The TDM tables only use these values as keys
+ * and indexes, so they have to be distinct but don't have to match the device headers.
+ */
+
+typedef enum tdm_attr {
+    TDM_ATTR_SRAM_AMOUNT,
+    TDM_ATTR_AFBC,
+    TDM_ATTR_SBWC,
+    TDM_ATTR_ITP,
+    TDM_ATTR_ROT_90,
+    TDM_ATTR_SCALE,
+    TDM_ATTR_WCG,
+    TDM_ATTR_MAX,
+} tdm_attr_t;
+
+enum {
+    RGB = 0x00000001,
+    YUV420 = 0x00000002,
+    YUV422 = 0x00000004,
+    FORMAT_RGB_MASK = 0x0000000F,
+    BIT8 = 0x00000010,
+    BIT10 = 0x00000020,
+    FORMAT_YUV_MASK = 0x000000F0,
+};
+
+#endif // _TDM_PLATFORM_HOST_ZUMAPRO_H
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _LEGACY_SRAM_AMOUNT_MAP_ZUMAPRO_H
+#define _LEGACY_SRAM_AMOUNT_MAP_ZUMAPRO_H
+
+#include <map>
+#include <optional>
+#include <tuple>
+
+#include "TDMResourceTables.h"
+
+namespace zumapro {
+
+typedef std::tuple<tdm_attr_t, uint32_t, lbWidthIndex_t> LegacySramKey;
+
+// sramAmountMap as it was written before sramAmountTable replaced it, keyed the same way
+inline const std::map<LegacySramKey, uint32_t> kLegacySramAmountMap = {
+        /** Non rotation **/
+        /** BIT8 = 32bit format **/
+        {{TDM_ATTR_AFBC, RGB | BIT8, LB_W_8_512}, 4},
+        {{TDM_ATTR_AFBC, RGB | BIT8, LB_W_513_1024}, 4},
+        {{TDM_ATTR_AFBC, RGB | BIT8, LB_W_1025_1536}, 8},
+        {{TDM_ATTR_AFBC, RGB | BIT8, LB_W_1537_2048}, 8},
+        {{TDM_ATTR_AFBC, RGB | BIT8, LB_W_2049_2304}, 12},
+        {{TDM_ATTR_AFBC, RGB | BIT8, LB_W_2305_2560}, 12},
+        {{TDM_ATTR_AFBC, RGB | BIT8, LB_W_2561_3072}, 12},
+        {{TDM_ATTR_AFBC, RGB | BIT8, LB_W_3073_INF}, 16},
+
+        /** 16bit format **/
+        {{TDM_ATTR_AFBC, RGB, LB_W_8_512}, 2},
+        {{TDM_ATTR_AFBC, RGB, LB_W_513_1024}, 2},
+        {{TDM_ATTR_AFBC, RGB, LB_W_1025_1536}, 4},
+        {{TDM_ATTR_AFBC, RGB, LB_W_1537_2048}, 4},
+        {{TDM_ATTR_AFBC, RGB, LB_W_2049_2304}, 6},
+        {{TDM_ATTR_AFBC, RGB, LB_W_2305_2560}, 6},
+        {{TDM_ATTR_AFBC, RGB, LB_W_2561_3072}, 6},
+        {{TDM_ATTR_AFBC, RGB, LB_W_3073_INF}, 8},
+
+        {{TDM_ATTR_SBWC, SBWC_Y, LB_W_8_512}, 1},
+        {{TDM_ATTR_SBWC, SBWC_Y, LB_W_513_1024}, 1},
+        {{TDM_ATTR_SBWC, SBWC_Y, LB_W_1025_1536}, 1},
+        {{TDM_ATTR_SBWC, SBWC_Y, LB_W_1537_2048}, 1},
+        {{TDM_ATTR_SBWC, SBWC_Y, LB_W_2049_2304}, 2},
+        {{TDM_ATTR_SBWC, SBWC_Y, LB_W_2305_2560}, 2},
+        {{TDM_ATTR_SBWC, SBWC_Y, LB_W_2561_3072}, 2},
+        {{TDM_ATTR_SBWC, SBWC_Y, LB_W_3073_INF}, 2},
+
+        {{TDM_ATTR_SBWC, SBWC_UV, LB_W_8_512}, 2},
+        {{TDM_ATTR_SBWC, SBWC_UV, LB_W_513_1024}, 2},
+        {{TDM_ATTR_SBWC, SBWC_UV, LB_W_1025_1536}, 2},
+        {{TDM_ATTR_SBWC, SBWC_UV, LB_W_1537_2048}, 2},
+        {{TDM_ATTR_SBWC, SBWC_UV, LB_W_2049_2304}, 2},
+        {{TDM_ATTR_SBWC, SBWC_UV, LB_W_2305_2560}, 2},
+        {{TDM_ATTR_SBWC, SBWC_UV, LB_W_2561_3072}, 2},
+        {{TDM_ATTR_SBWC, SBWC_UV, LB_W_3073_INF}, 2},
+
+        /** Rotation **/
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_8_512}, 4},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_513_1024}, 8},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_1025_1536}, 12},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_1537_2048}, 16},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_2049_2304}, 18},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_2305_2560}, 18},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_2561_3072}, 18},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_3073_INF}, 18},
+
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_8_512}, 2},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_513_1024}, 4},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_1025_1536}, 6},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_1537_2048}, 8},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_2049_2304}, 10},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_2305_2560}, 10},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_2561_3072}, 10},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_3073_INF}, 10},
+
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_8_512}, 2},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_513_1024}, 4},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_1025_1536}, 6},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_1537_2048}, 8},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_2049_2304}, 9},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_2305_2560}, 9},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_2561_3072}, 9},
+        {{TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_3073_INF}, 9},
+
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_8_512}, 2},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_513_1024}, 2},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_1025_1536}, 4},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_1537_2048}, 4},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_2049_2304}, 6},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_2305_2560}, 6},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_2561_3072}, 6},
+        {{TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_3073_INF}, 6},
+
+        {{TDM_ATTR_ROT_90, SBWC_Y, LB_W_8_512}, 2},
+        {{TDM_ATTR_ROT_90, SBWC_Y, LB_W_513_1024}, 4},
+        {{TDM_ATTR_ROT_90, SBWC_Y, LB_W_1025_1536}, 6},
+        {{TDM_ATTR_ROT_90, SBWC_Y, LB_W_1537_2048}, 8},
+        {{TDM_ATTR_ROT_90, SBWC_Y, LB_W_2049_2304}, 9},
+        {{TDM_ATTR_ROT_90, SBWC_Y, LB_W_2305_2560}, 9},
+        {{TDM_ATTR_ROT_90, SBWC_Y, LB_W_2561_3072}, 9},
+        {{TDM_ATTR_ROT_90, SBWC_Y, LB_W_3073_INF}, 9},
+
+        {{TDM_ATTR_ROT_90, SBWC_UV, LB_W_8_512}, 2},
+        {{TDM_ATTR_ROT_90, SBWC_UV, LB_W_513_1024}, 2},
+        {{TDM_ATTR_ROT_90, SBWC_UV, LB_W_1025_1536}, 4},
+        {{TDM_ATTR_ROT_90, SBWC_UV, LB_W_1537_2048}, 4},
+        {{TDM_ATTR_ROT_90, SBWC_UV, LB_W_2049_2304}, 6},
+        {{TDM_ATTR_ROT_90, SBWC_UV, LB_W_2305_2560}, 6},
+        {{TDM_ATTR_ROT_90, SBWC_UV, LB_W_2561_3072}, 6},
+        {{TDM_ATTR_ROT_90, SBWC_UV, LB_W_3073_INF}, 6},
+
+        {{TDM_ATTR_ITP, BIT8, LB_W_3073_INF}, 2},
+        {{TDM_ATTR_ITP, BIT10, LB_W_3073_INF}, 2},
+
+        /* It's meaning like ow,
+         * FORMAT_YUV_MASK == has no alpha, FORMAT_RGB_MASK == has alpha */
+        {{TDM_ATTR_SCALE, FORMAT_YUV_MASK, LB_W_3073_INF}, 12},
+        {{TDM_ATTR_SCALE, FORMAT_RGB_MASK, LB_W_3073_INF}, 16},
+};
+
+inline std::optional<uint32_t> getLegacySramAmount(tdm_attr_t attr, uint32_t formatProperty,
+                                                   lbWidthIndex_t widthIndex) {
+    auto it = kLegacySramAmountMap.find({attr, formatProperty, widthIndex});
+    if (it == kLegacySramAmountMap.end()) return std::nullopt;
+    return it->second;
+}
+
+} // namespace zumapro
+
+#endif // _LEGACY_SRAM_AMOUNT_MAP_ZUMAPRO_H
@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "TDMAssignmentSolver.h"
+
+using namespace zumapro;
+
+namespace {
+
+constexpr auto kShare = TDMBudgetLedger::Share::TOTAL;
+constexpr ConstraintRev_t kConstraintRev = CONSTRAINT_B0;
+
+TDMChannel_t makeChannel(const char* name, uint32_t index, DPUblockId_t blockId,
+                         AXIPortId_t axiId, bool yuv) {
+    // VGRFS rotates, both kinds scale
+    return {name, yuv ? 1u : 0u, index, blockId, axiId, yuv, yuv, 8, 4};
+}
+
+// a smaller channel set than zumapro so that the exhaustive search stays fast
+std::vector<TDMChannel_t> getChannels() {
+    return {
+            makeChannel("GFS0", 0, DPUF0, AXI0, false),
+            makeChannel("VGRFS0", 0, DPUF0, AXI0, true),
+            makeChannel("GFS1", 1, DPUF0, AXI1, false),
+            makeChannel("GFS2", 2, DPUF1, AXI1, false),
+            makeChannel("VGRFS1", 1, DPUF1, AXI0, true),
+    };
+}
+
+TDMLayerInfo_t makeLayer(std::mt19937& rng) {
+    TDMLayerInfo_t layer = {};
+    layer.yuv = rng() % 3 == 0;
+    layer.srcWidth = 256 + rng() % 2800;
+    layer.srcHeight = 256 + rng() % 2800;
+    layer.rot90 = layer.yuv && rng() % 3 == 0;
+    uint32_t srcWidth = layer.rot90 ? layer.srcHeight : layer.srcWidth;
+    uint32_t srcHeight = layer.rot90 ? layer.srcWidth : layer.srcHeight;
+    switch (rng() % 4) {
+        case 0: // 1/8, out of the downscale limit
+            layer.dstWidth = std::max(srcWidth / 8, 1u);
+            layer.dstHeight = std::max(srcHeight / 8, 1u);
+            break;
+        case 1:
+            layer.dstWidth = srcWidth / 2;
+            layer.dstHeight = srcHeight / 2;
+            break;
+        default:
+            layer.dstWidth = srcWidth;
+            layer.dstHeight = srcHeight;
+            break;
+    }
+    layer.bit10 = layer.yuv && rng() % 2;
+    layer.sbwc = layer.yuv && rng() % 2;
+    layer.hasAlpha = !layer.yuv;
+    layer.afbc = !layer.yuv && rng() % 2;
+    layer.wcg = rng() % 3 == 0;
+    return layer;
+}
+
+uint64_t getPixels(const TDMLayerInfo_t& layer) {
+    return static_cast<uint64_t>(layer.dstWidth) * layer.dstHeight;
+}
+
+/* check the result is a valid assignment and return its client pixels */
+uint64_t verify(const std::vector<TDMChannel_t>& channels,
+                const std::vector<TDMLayerInfo_t>& layers, const TDMLayerInfo_t& clientTarget,
+                const TDMResourceModel::Result_t& result,
+                const TDMReservation_t* reservation = nullptr) {
+    EXPECT_EQ(result.channels.size(), layers.size());
+    TDMResourceModel model(channels);
+    model.reset(kConstraintRev, kShare, reservation);
+
+    size_t first = layers.size(), last = 0;
+    uint64_t pixels = 0;
+    for (size_t i = 0; i < layers.size(); i++) {
+        int32_t channel = result.channels[i];
+        if (channel == TDMResourceModel::kClientComposition) {
+            first = std::min(first, i);
+            last = std::max(last, i);
+            pixels += getPixels(layers[i]);
+            continue;
+        }
+        EXPECT_TRUE(TDMResourceModel::isSupported(channels[channel], layers[i]));
+        EXPECT_TRUE(model.tryAssign(channel, TDMResourceModel::getDemand(layers[i])));
+    }
+    if (first > last) {
+        EXPECT_EQ(result.clientLayerCnt, 0u);
+        EXPECT_EQ(result.clientTargetChannel, TDMResourceModel::kClientComposition);
+        return 0;
+    }
+    // the client layers are contiguous in z-order
+    EXPECT_EQ(result.clientLayerCnt, last - first + 1);
+    EXPECT_EQ(result.clientPixels, pixels);
+
+    int32_t channel = result.clientTargetChannel;
+    if (channel != TDMResourceModel::kClientComposition) {
+        EXPECT_TRUE(model.tryAssign(channel, TDMResourceModel::getDemand(clientTarget)));
+    } else {
+        EXPECT_EQ(result.clientLayerCnt, layers.size());
+    }
+    return pixels;
+}
+
+bool placeAll(TDMResourceModel& model, const std::vector<const TDMLayerInfo_t*>& items,
+              size_t depth) {
+    if (depth == items.size()) return true;
+    const auto& channels = model.getChannels();
+    for (uint32_t i = 0; i < channels.size(); i++) {
+        auto demand = TDMResourceModel::getDemand(*items[depth]);
+        if (!TDMResourceModel::isSupported(channels[i], *items[depth]) ||
+            !model.tryAssign(i, demand))
+            continue;
+        if (placeAll(model, items, depth + 1)) return true;
+        model.unassign(i, demand);
+    }
+    return false;
+}
+
+/* fewest client pixels over every contiguous client range and every channel mapping */
+std::optional<uint64_t> searchExhaustive(const std::vector<TDMChannel_t>& channels,
+                                         const std::vector<TDMLayerInfo_t>& layers,
+                                         const TDMLayerInfo_t& clientTarget,
+                                         const TDMReservation_t* reservation = nullptr) {
+    TDMResourceModel model(channels);
+    std::optional<uint64_t> best;
+    auto tryRange = [&](size_t first, size_t last) {
+        std::vector<const TDMLayerInfo_t*> items;
+        uint64_t pixels = 0;
+        for (size_t i = 0; i < layers.size(); i++) {
+            if (first <= i && i <= last) {
+                pixels += getPixels(layers[i]);
+            } else {
+                items.push_back(&layers[i]);
+            }
+        }
+        if (first <= last) items.push_back(&clientTarget);
+        if (best && pixels >= *best) return;
+        model.reset(kConstraintRev, kShare, reservation);
+        if (placeAll(model, items, 0)) best = pixels;
+    };
+    tryRange(layers.size(), 0);
+    for (size_t first = 0; first < layers.size(); first++) {
+        for (size_t last = first; last < layers.size(); last++) tryRange(first, last);
+    }
+    return best;
+}
+
+} // namespace
+
+TEST(TDMResourceModelTest, IsSupportedChecksRotationAndScaling) {
+    TDMChannel_t gfs = makeChannel("GFS0", 0, DPUF0, AXI0, false);
+    TDMChannel_t vgrfs = makeChannel("VGRFS0", 0, DPUF0, AXI0, true);
+    TDMChannel_t fixed = gfs;
+    fixed.maxUpscale = fixed.maxDownscale = 1;
+
+    TDMLayerInfo_t layer = {};
+    layer.srcWidth = layer.dstWidth = 1080;
+    layer.srcHeight = layer.dstHeight = 2400;
+    EXPECT_TRUE(TDMResourceModel::isSupported(fixed, layer));
+
+    layer.yuv = true;
+    EXPECT_FALSE(TDMResourceModel::isSupported(gfs, layer));
+    EXPECT_TRUE(TDMResourceModel::isSupported(vgrfs, layer));
+
+    // the rotated source matches the destination without scaling
+    layer.rot90 = true;
+    layer.srcWidth = 2400;
+    layer.srcHeight = 1080;
+    EXPECT_TRUE(TDMResourceModel::isSupported(vgrfs, layer));
+    vgrfs.rot90 = false;
+    EXPECT_FALSE(TDMResourceModel::isSupported(vgrfs, layer));
+
+    layer = {};
+    layer.srcWidth = 1080;
+    layer.srcHeight = 2400;
+    layer.dstWidth = 1080 / 4;
+    layer.dstHeight = 2400 / 4;
+    EXPECT_TRUE(TDMResourceModel::isSupported(gfs, layer));
+    EXPECT_FALSE(TDMResourceModel::isSupported(fixed, layer));
+    layer.dstWidth = 1080 / 5;
+    EXPECT_FALSE(TDMResourceModel::isSupported(gfs, layer));
+
+    layer.dstWidth = 1080 * 8;
+    layer.dstHeight = 2400 * 8;
+    EXPECT_TRUE(TDMResourceModel::isSupported(gfs, layer));
+    layer.dstHeight = 2400 * 8 + 1;
+    EXPECT_FALSE(TDMResourceModel::isSupported(gfs, layer));
+}
+
+TEST(TDMResourceModelTest, ClientRangeIsContiguous) {
+    auto channels = getChannels();
+    TDMResourceModel model(channels);
+    TDMLayerInfo_t clientTarget = TDMLayerInfo_t{};
+    clientTarget.srcWidth = clientTarget.dstWidth = 1344;
+    clientTarget.srcHeight = clientTarget.dstHeight = 2992;
+    clientTarget.hasAlpha = true;
+
+    std::mt19937 rng(1);
+    for (int run = 0; run < 2000; run++) {
+        std::vector<TDMLayerInfo_t> layers(1 + rng() % 9);
+        for (auto& layer : layers) layer = makeLayer(rng);
+
+        TDMResourceModel::Result_t result;
+        model.reset(kConstraintRev, kShare);
+        model.assign(layers, clientTarget, result);
+        verify(channels, layers, clientTarget, result);
+        if (HasFailure()) FAIL() << "run " << run;
+    }
+}
+
+TEST(TDMAssignmentSolverTest, MatchesExhaustiveSearch) {
+    auto channels = getChannels();
+    TDMResourceModel model(channels);
+    // large enough to never time out on these stacks
+    TDMAssignmentSolver solver(channels, std::chrono::seconds(10));
+    TDMLayerInfo_t clientTarget = TDMLayerInfo_t{};
+    clientTarget.srcWidth = clientTarget.dstWidth = 1344;
+    clientTarget.srcHeight = clientTarget.dstHeight = 2992;
+    clientTarget.hasAlpha = true;
+
+    std::mt19937 rng(2);
+    uint32_t improvedCnt = 0;
+    for (int run = 0; run < 1000; run++) {
+        std::vector<TDMLayerInfo_t> layers(1 + rng() % 7);
+        for (auto& layer : layers) layer = makeLayer(rng);
+
+        TDMResourceModel::Result_t tableOrder;
+        model.reset(kConstraintRev, kShare);
+        model.assign(layers, clientTarget, tableOrder);
+        uint64_t tablePixels = verify(channels, layers, clientTarget, tableOrder);
+
+        TDMResourceModel::Result_t result;
+        ASSERT_TRUE(solver.solve(layers, clientTarget, kConstraintRev, kShare, result));
+        uint64_t solverPixels = verify(channels, layers, clientTarget, result);
+        if (HasFailure()) FAIL() << "run " << run;
+
+        EXPECT_LE(solverPixels, tablePixels) << "run " << run;
+        if (auto best = searchExhaustive(channels, layers, clientTarget)) {
+            EXPECT_EQ(solverPixels, *best) << "run " << run;
+        } else {
+            // nothing fits, the table order result is kept
+            EXPECT_EQ(solverPixels, tablePixels) << "run " << run;
+        }
+        improvedCnt += solverPixels < tablePixels;
+    }
+    // the stacks are meant to exercise the search, not only the table order
+    EXPECT_GT(improvedCnt, 0u);
+}
+
+TEST(TDMAssignmentSolverTest, KeepsOffReservedChannels) {
+    auto channels = getChannels();
+    TDMResourceModel model(channels);
+    TDMAssignmentSolver solver(channels, std::chrono::seconds(10));
+    TDMLayerInfo_t clientTarget = TDMLayerInfo_t{};
+    clientTarget.srcWidth = clientTarget.dstWidth = 1344;
+    clientTarget.srcHeight = clientTarget.dstHeight = 2992;
+    clientTarget.hasAlpha = true;
+
+    std::mt19937 rng(3);
+    for (int run = 0; run < 500; run++) {
+        // layers another display has on some of the channels
+        TDMReservation_t reservation = {};
+        model.reset(kConstraintRev, kShare);
+        for (uint32_t i = 0; i < channels.size(); i++) {
+            if (rng() % 3) continue;
+            TDMLayerInfo_t other = makeLayer(rng);
+            if (!TDMResourceModel::isSupported(channels[i], other)) continue;
+            model.tryAssign(i, TDMResourceModel::getDemand(other));
+        }
+        for (uint32_t i = 0; i < channels.size(); i++) {
+            if (!model.isChannelFree(i)) reservation.busyChannels |= 1u << i;
+        }
+        reservation.usage = model.getLedger().snapshot();
+
+        std::vector<TDMLayerInfo_t> layers(1 + rng() % 5);
+        for (auto& layer : layers) layer = makeLayer(rng);
+
+        TDMResourceModel::Result_t result;
+        ASSERT_TRUE(solver.solve(layers, clientTarget, kConstraintRev, kShare, result,
+                                 &reservation));
+        uint64_t solverPixels = verify(channels, layers, clientTarget, result, &reservation);
+        for (int32_t channel : result.channels) {
+            if (channel == TDMResourceModel::kClientComposition) continue;
+            EXPECT_FALSE(reservation.busyChannels & (1u << channel)) << "run " << run;
+        }
+        if (auto best = searchExhaustive(channels, layers, clientTarget, &reservation)) {
+            EXPECT_EQ(solverPixels, *best) << "run " << run;
+        }
+        if (HasFailure()) FAIL() << "run " << run;
+    }
+}
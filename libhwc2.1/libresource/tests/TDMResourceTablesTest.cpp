@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <tuple>
+
+#include "TDMResourceTables.h"
+#include "tests/LegacySramAmountMap.h"
+
+using namespace zumapro;
+
+namespace {
+
+// HWResourceIndexes with the wildcard comparator HWResourceTables was searched with
+class LegacyHWResourceIndexes {
+public:
+    LegacyHWResourceIndexes(tdm_attr_t attr, DPUblockId_t blockId, AXIPortId_t axiId,
+                            ConstraintRev_t constraintRev)
+          : mAttr(attr), mBlockId(blockId), mAxiId(axiId), mConstraintRev(constraintRev) {}
+    bool operator<(const LegacyHWResourceIndexes& rhs) const {
+        if (mAttr != rhs.mAttr) return mAttr < rhs.mAttr;
+
+        if (mBlockId != rhs.mBlockId) return mBlockId < rhs.mBlockId;
+
+        if (mAxiId != AXI_DONT_CARE && rhs.mAxiId != AXI_DONT_CARE && mAxiId != rhs.mAxiId)
+            return mAxiId < rhs.mAxiId;
+
+        if (mConstraintRev != CONSTRAINT_NONE) return mConstraintRev < rhs.mConstraintRev;
+
+        return false;
+    }
+
+private:
+    tdm_attr_t mAttr;
+    DPUblockId_t mBlockId;
+    AXIPortId_t mAxiId;
+    ConstraintRev_t mConstraintRev;
+};
+
+// HWResourceTables as it was written before HWResourceEntries replaced it
+const std::map<LegacyHWResourceIndexes, HWResourceAmounts_t> kLegacyHWResourceTables = {
+        // SRAM
+        {LegacyHWResourceIndexes(TDM_ATTR_SRAM_AMOUNT, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {50, 30, 80}},
+        {LegacyHWResourceIndexes(TDM_ATTR_SRAM_AMOUNT, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {50, 30, 80}},
+        // SCALE
+        {LegacyHWResourceIndexes(TDM_ATTR_SCALE, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {2, 0, 2}},
+        {LegacyHWResourceIndexes(TDM_ATTR_SCALE, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {1, 1, 2}},
+        // SBWC
+        {LegacyHWResourceIndexes(TDM_ATTR_SBWC, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {2, 0, 2}},
+        {LegacyHWResourceIndexes(TDM_ATTR_SBWC, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {0, 2, 2}},
+        // AFBC
+        {LegacyHWResourceIndexes(TDM_ATTR_AFBC, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {3, 1, 4}},
+        {LegacyHWResourceIndexes(TDM_ATTR_AFBC, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {1, 3, 4}},
+        // ITP
+        {LegacyHWResourceIndexes(TDM_ATTR_ITP, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {3, 1, 4}},
+        {LegacyHWResourceIndexes(TDM_ATTR_ITP, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {1, 3, 4}},
+        // ROT_90
+        {LegacyHWResourceIndexes(TDM_ATTR_ROT_90, DPUF0, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {1, 1, 2}},
+        {LegacyHWResourceIndexes(TDM_ATTR_ROT_90, DPUF1, AXI_DONT_CARE, CONSTRAINT_NONE),
+         {1, 1, 2}},
+        // WCG
+        {LegacyHWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI_DONT_CARE, CONSTRAINT_A0),
+         {2, 0, 2}},
+        {LegacyHWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI_DONT_CARE, CONSTRAINT_A0),
+         {0, 2, 2}},
+        {LegacyHWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI0, CONSTRAINT_B0),
+         {2, 0, 2}},
+        {LegacyHWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI1, CONSTRAINT_B0),
+         {2, 0, 2}},
+        {LegacyHWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI0, CONSTRAINT_B0),
+         {0, 2, 2}},
+        {LegacyHWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI1, CONSTRAINT_B0),
+         {0, 2, 2}},
+};
+
+std::optional<HWResourceAmounts_t> getLegacyHWResourceAmounts(tdm_attr_t attr,
+                                                              DPUblockId_t blockId,
+                                                              AXIPortId_t axiId,
+                                                              ConstraintRev_t constraintRev) {
+    auto it = kLegacyHWResourceTables.find(
+            LegacyHWResourceIndexes(attr, blockId, axiId, constraintRev));
+    if (it == kLegacyHWResourceTables.end()) return std::nullopt;
+    return it->second;
+}
+
+void expectSameAmounts(const std::optional<HWResourceAmounts_t>& actual,
+                       const std::optional<HWResourceAmounts_t>& expected) {
+    ASSERT_EQ(actual.has_value(), expected.has_value());
+    if (!expected) return;
+    EXPECT_EQ(actual->mainAmount, expected->mainAmount);
+    EXPECT_EQ(actual->minorAmount, expected->minorAmount);
+    EXPECT_EQ(actual->total, expected->total);
+}
+
+} // namespace
+
+TEST(TDMResourceTablesTest, SramAmountMatchesLegacyMap) {
+    // every format property bit combination up to BIT10, including the ones without a row
+    constexpr uint32_t kFormatPropertyEnd = (BIT10 | FORMAT_YUV_MASK | FORMAT_RGB_MASK) + 1;
+    for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+        for (uint32_t format = 0; format < kFormatPropertyEnd; format++) {
+            for (uint32_t width = 0; width < LB_W_INDEX_MAX; width++) {
+                auto tdmAttr = static_cast<tdm_attr_t>(attr);
+                auto widthIndex = static_cast<lbWidthIndex_t>(width);
+                EXPECT_EQ(getSramAmount(tdmAttr, format, widthIndex),
+                          getLegacySramAmount(tdmAttr, format, widthIndex))
+                        << "attr " << attr << " format 0x" << std::hex << format << std::dec
+                        << " width index " << width;
+            }
+        }
+    }
+}
+
+TEST(TDMResourceTablesTest, SramAmountCoversLegacyMap) {
+    for (const auto& [key, amount] : kLegacySramAmountMap) {
+        const auto& [attr, format, widthIndex] = key;
+        EXPECT_EQ(getSramAmount(attr, format, widthIndex), amount);
+    }
+}
+
+TEST(TDMResourceTablesTest, SramAmountRejectsOutOfRange) {
+    EXPECT_FALSE(getSramAmount(TDM_ATTR_MAX, RGB | BIT8, LB_W_8_512));
+    EXPECT_FALSE(getSramAmount(TDM_ATTR_AFBC, RGB | BIT8, LB_W_INDEX_MAX));
+}
+
+TEST(TDMResourceTablesTest, HWResourceAmountsMatchLegacyTables) {
+    constexpr AXIPortId_t kAxiIds[] = {AXI0, AXI1, AXI_DONT_CARE};
+    for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+        for (uint32_t blockId = 0; blockId < DPU_BLOCK_CNT; blockId++) {
+            for (auto axiId : kAxiIds) {
+                for (uint32_t rev = 0; rev < CONSTRAINT_REV_CNT; rev++) {
+                    auto tdmAttr = static_cast<tdm_attr_t>(attr);
+                    auto block = static_cast<DPUblockId_t>(blockId);
+                    auto constraintRev = static_cast<ConstraintRev_t>(rev);
+                    auto legacy = getLegacyHWResourceAmounts(tdmAttr, block, axiId, constraintRev);
+                    // the legacy comparator misses the A0 WCG budget of the second port of
+                    // DPUF1, the slots answer it like the DPUF0 one
+                    if (tdmAttr == TDM_ATTR_WCG && block == DPUF1 && axiId == AXI1 &&
+                        constraintRev == CONSTRAINT_A0) {
+                        EXPECT_FALSE(legacy);
+                        legacy = getLegacyHWResourceAmounts(tdmAttr, block, AXI_DONT_CARE,
+                                                            constraintRev);
+                    }
+                    SCOPED_TRACE(testing::Message() << "attr " << attr << " block " << blockId
+                                                    << " axi " << axiId << " rev " << rev);
+                    expectSameAmounts(getHWResourceAmounts(tdmAttr, block, axiId, constraintRev),
+                                      legacy);
+                }
+            }
+        }
+    }
+}
+
+TEST(TDMResourceTablesTest, HWResourceSlotsExpandWildcards) {
+    // AXI_DONT_CARE entries cover both ports with one shared budget
+    for (auto axiId : {AXI0, AXI1}) {
+        const auto& slot = HWResourceSlots[getHWResourceSlotIndex(TDM_ATTR_SRAM_AMOUNT, DPUF0,
+                                                                  axiId, CONSTRAINT_B0)];
+        EXPECT_TRUE(slot.valid);
+        EXPECT_TRUE(slot.axiShared);
+        EXPECT_EQ(slot.amounts.total, 80);
+    }
+    // per-port B0 entries are not shared
+    const auto& wcg =
+            HWResourceSlots[getHWResourceSlotIndex(TDM_ATTR_WCG, DPUF0, AXI1, CONSTRAINT_B0)];
+    EXPECT_TRUE(wcg.valid);
+    EXPECT_FALSE(wcg.axiShared);
+
+    // CONSTRAINT_NONE entries cover every revision
+    for (uint32_t rev = 0; rev < CONSTRAINT_REV_CNT; rev++) {
+        auto amounts = getHWResourceAmounts(TDM_ATTR_ROT_90, DPUF1, AXI0,
+                                            static_cast<ConstraintRev_t>(rev));
+        ASSERT_TRUE(amounts);
+        EXPECT_EQ(amounts->total, 2);
+    }
+    // A0 and B0 agree on the WCG budget of DPUF0, so CONSTRAINT_NONE gets it too
+    EXPECT_TRUE(getHWResourceAmounts(TDM_ATTR_WCG, DPUF0, AXI0, CONSTRAINT_NONE));
+    EXPECT_FALSE(getHWResourceAmounts(TDM_ATTR_WCG, DPUF0, AXI0, CONSTRAINT_REV_CNT));
+}
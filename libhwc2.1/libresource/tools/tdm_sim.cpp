@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Replays recorded layer stacks on the host and compares the table order assignment of
+ * TDMResourceModel with TDMAssignmentSolver: how many frames and layers fall back to client
+ * composition, and how long each takes per validate. The input is dumpsys or logcat output
+ * with the tdm_channel and tdm_stack lines of TDMTrace.
+ *
+ *   zumapro_tdm_sim --budget-us 200 --iterations 100 stacks.txt
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "TDMAssignmentSolver.h"
+#include "TDMTrace.h"
+
+using namespace zumapro;
+
+namespace {
+
+typedef struct Summary {
+    uint64_t clientFrameCnt;
+    uint64_t clientLayerCnt;
+    uint64_t clientPixels;
+    int64_t totalNs;
+    uint64_t runCnt;
+} Summary_t;
+
+void usage(const char* name) {
+    fprintf(stderr,
+            "usage: %s [options] <stacks|->\n"
+            "  --budget-us <us>           vendor.display.tdm.solver_budget_us (default 200)\n"
+            "  --iterations <n>           runs of each stack for the timing (default 100)\n"
+            "  --share <main|minor|total> budget share of the display (default total)\n"
+            "  --constraint <none|a0|b0>  DPU constraint revision (default b0)\n"
+            "input lines: tdm_channel ... and tdm_stack ..., see TDMTrace.h\n",
+            name);
+}
+
+void account(Summary_t& summary, const TDMResourceModel::Result_t& result) {
+    if (!result.clientLayerCnt) return;
+    summary.clientFrameCnt++;
+    summary.clientLayerCnt += result.clientLayerCnt;
+    summary.clientPixels += result.clientPixels;
+}
+
+void print(const char* name, const Summary_t& summary, uint64_t frameCnt) {
+    printf("# %-10s client frames %" PRIu64 "/%" PRIu64 ", client layers %" PRIu64
+           ", client pixels %" PRIu64 ", %.0f ns per validate\n",
+           name, summary.clientFrameCnt, frameCnt, summary.clientLayerCnt, summary.clientPixels,
+           summary.runCnt ? static_cast<double>(summary.totalNs) / summary.runCnt : 0.0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int64_t budgetUs = 200;
+    uint32_t iterations = 100;
+    auto share = TDMBudgetLedger::Share::TOTAL;
+    auto constraintRev = CONSTRAINT_B0;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                exit(1);
+            }
+            return argv[++i];
+        };
+        if (!strcmp(argv[i], "--budget-us")) {
+            budgetUs = atoll(next());
+        } else if (!strcmp(argv[i], "--iterations")) {
+            iterations = std::max(atoi(next()), 1);
+        } else if (!strcmp(argv[i], "--share")) {
+            const char* value = next();
+            if (!strcmp(value, "main")) {
+                share = TDMBudgetLedger::Share::MAIN;
+            } else if (!strcmp(value, "minor")) {
+                share = TDMBudgetLedger::Share::MINOR;
+            } else if (!strcmp(value, "total")) {
+                share = TDMBudgetLedger::Share::TOTAL;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--constraint")) {
+            const char* value = next();
+            if (!strcmp(value, "none")) {
+                constraintRev = CONSTRAINT_NONE;
+            } else if (!strcmp(value, "a0")) {
+                constraintRev = CONSTRAINT_A0;
+            } else if (!strcmp(value, "b0")) {
+                constraintRev = CONSTRAINT_B0;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!path && (argv[i][0] != '-' || !strcmp(argv[i], "-"))) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!path) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream file;
+    if (strcmp(path, "-")) {
+        file.open(path);
+        if (!file) {
+            fprintf(stderr, "failed to open %s\n", path);
+            return 1;
+        }
+    }
+    std::istream& input = file.is_open() ? file : std::cin;
+
+    std::vector<TDMChannel_t> channels;
+    std::vector<TDMTrace::Record_t> stacks;
+    int lineNo = 0;
+    for (std::string line; std::getline(input, line);) {
+        lineNo++;
+        bool error;
+        auto record = TDMTrace::parse(line, &error);
+        if (error) {
+            fprintf(stderr, "line %d: invalid record '%s'\n", lineNo, line.c_str());
+            return 1;
+        }
+        if (!record) continue;
+        if (record->type == TDMTrace::Record_t::Type::CHANNEL) {
+            // a dump repeats the channels, keep the first set
+            if (!stacks.empty()) continue;
+            bool known = false;
+            for (const auto& channel : channels) known |= (channel.name == record->channel.name);
+            if (!known) channels.push_back(record->channel);
+        } else {
+            stacks.push_back(std::move(*record));
+        }
+    }
+    if (channels.empty() || channels.size() > TDMResourceModel::kMaxChannelCnt) {
+        fprintf(stderr, "need 1 to %u tdm_channel lines before the stacks\n",
+                TDMResourceModel::kMaxChannelCnt);
+        return 1;
+    }
+
+    TDMResourceModel model(channels);
+    TDMAssignmentSolver solver(channels, std::chrono::microseconds(budgetUs));
+    Summary_t tableOrder = {};
+    Summary_t optimal = {};
+    TDMResourceModel::Result_t result;
+    for (const auto& stack : stacks) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++) {
+            model.reset(constraintRev, share);
+            model.assign(stack.layers, stack.clientTarget, result);
+        }
+        auto end = std::chrono::steady_clock::now();
+        tableOrder.totalNs += std::chrono::nanoseconds(end - start).count();
+        tableOrder.runCnt += iterations;
+        account(tableOrder, result);
+
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++) {
+            solver.solve(stack.layers, stack.clientTarget, constraintRev, share, result);
+        }
+        end = std::chrono::steady_clock::now();
+        optimal.totalNs += std::chrono::nanoseconds(end - start).count();
+        optimal.runCnt += iterations;
+        account(optimal, result);
+    }
+
+    printf("# %zu channels, %zu stacks, solver budget %" PRId64 " us\n", channels.size(),
+           stacks.size(), budgetUs);
+    print("table", tableOrder, stacks.size());
+    print("solver", optimal, stacks.size());
+    const auto& stats = solver.getStats();
+    printf("# solver: solved %" PRIu64 ", improved %" PRIu64 ", timeout %" PRIu64 "\n",
+           stats.solveCnt, stats.improvedCnt, stats.timeoutCnt);
+    return 0;
+}
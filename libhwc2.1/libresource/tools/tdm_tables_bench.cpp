@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Times the SRAM amount lookups of recorded layer stacks against the std::map sramAmountMap
+ * that getSramAmount() replaced. Every layer of every tdm_stack line is expanded into the
+ * lookups TDMResourceModel::getDemand() makes, and the whole mix is looked up in both tables
+ * until the requested count is reached. The sums of both runs must match.
+ *
+ *   zumapro_tdm_tables_bench --lookups 10000000 stacks.txt
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "TDMResourceModel.h"
+#include "TDMTrace.h"
+#include "tests/LegacySramAmountMap.h"
+
+using namespace zumapro;
+
+namespace {
+
+typedef struct Lookup {
+    tdm_attr_t attr;
+    uint32_t formatProperty;
+    lbWidthIndex_t widthIndex;
+} Lookup_t;
+
+void usage(const char* name) {
+    fprintf(stderr,
+            "usage: %s [options] <stacks|->\n"
+            "  --lookups <n>  lookups per table (default 10000000)\n"
+            "input lines: tdm_stack ..., see TDMTrace.h\n",
+            name);
+}
+
+/* ns per lookup over `rounds` passes of the mix, `sum` keeps the lookups from being elided */
+template <typename Get>
+double run(const std::vector<Lookup_t>& mix, uint64_t rounds, Get&& get, uint64_t* sum) {
+    uint64_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < rounds; i++) {
+        for (const auto& lookup : mix) {
+            total += get(lookup.attr, lookup.formatProperty, lookup.widthIndex).value_or(0);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    *sum = total;
+    return static_cast<double>(std::chrono::nanoseconds(end - start).count()) /
+            static_cast<double>(rounds * mix.size());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t lookupCnt = 10000000;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--lookups") && i + 1 < argc) {
+            lookupCnt = std::max(strtoull(argv[++i], nullptr, 10), 1ull);
+        } else if (!path && (argv[i][0] != '-' || !strcmp(argv[i], "-"))) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!path) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream file;
+    if (strcmp(path, "-")) {
+        file.open(path);
+        if (!file) {
+            fprintf(stderr, "failed to open %s\n", path);
+            return 1;
+        }
+    }
+    std::istream& input = file.is_open() ? file : std::cin;
+
+    std::vector<Lookup_t> mix;
+    size_t layerCnt = 0;
+    int lineNo = 0;
+    for (std::string line; std::getline(input, line);) {
+        lineNo++;
+        bool error;
+        auto record = TDMTrace::parse(line, &error);
+        if (error) {
+            fprintf(stderr, "line %d: invalid record '%s'\n", lineNo, line.c_str());
+            return 1;
+        }
+        if (!record || record->type != TDMTrace::Record_t::Type::STACK) continue;
+        record->layers.push_back(record->clientTarget);
+        for (const auto& layer : record->layers) {
+            TDMResourceModel::forEachSramLookup(layer, [&](tdm_attr_t attr,
+                                                           uint32_t formatProperty,
+                                                           lbWidthIndex_t widthIndex) {
+                mix.push_back({attr, formatProperty, widthIndex});
+            });
+        }
+        layerCnt += record->layers.size();
+    }
+    if (mix.empty()) {
+        fprintf(stderr, "no SRAM lookups in the tdm_stack lines\n");
+        return 1;
+    }
+
+    uint64_t rounds = std::max<uint64_t>(lookupCnt / mix.size(), 1);
+    uint64_t tableSum;
+    uint64_t mapSum;
+    double tableNs = run(mix, rounds, getSramAmount, &tableSum);
+    double mapNs = run(mix, rounds, getLegacySramAmount, &mapSum);
+    if (tableSum != mapSum) {
+        fprintf(stderr, "table and map disagree: %" PRIu64 " != %" PRIu64 "\n", tableSum,
+                mapSum);
+        return 1;
+    }
+
+    printf("# %zu layers, %zu lookups per pass, %" PRIu64 " passes\n", layerCnt, mix.size(),
+           rounds);
+    printf("# %-6s %.2f ns per lookup\n", "table", tableNs);
+    printf("# %-6s %.2f ns per lookup\n", "map", mapNs);
+    return 0;
+}